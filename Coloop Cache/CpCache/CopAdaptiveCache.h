@@ -0,0 +1,225 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+#include "CopCachePolicy.h"
+#include "CopKeyTraits.h"
+#include "CopLockPolicy.h"
+#include "CopShardedCache.h"
+#include "CopLruCache.h"
+#include "CopLfuCache.h"
+#include "CopArcCache/CopArcCache.h"
+
+namespace CopCache {
+
+	//Ӧѡ̭
+	enum class CopPolicyKind
+	{
+		Lru,
+		Lfu,
+		Arc,
+		Slru
+	};
+
+	//Ӧѡ:ϣһּ,ΪÿֺѡԸһСӰӻ(ֻ),
+	//ڱȽϸӰӵ,ʵʹõĲлɵǰõһ
+	//лʱɲԲ̶:²δʱزɲԲǨ,ɲֻͬеļ,
+	//²ۼдͻزkDrainRoundsɲԲűͷ,ڼ²𲽽־ɵĹ
+	//ڲԶʹCopNullLock,LockPolicyͳһ
+	template <typename Key, typename Value, typename LockPolicy = CopMutexLock>
+	class CopAdaptiveCache : public CopCachePolicy<Key, Value>
+	{
+	public:
+		//sampleRateʾÿٸһ,ӰӻӦС;СʱԶͳ
+		//windowΪÿֱȽĳ
+		//ĬϴARC:л²ֻܴӾɲǨе,𲽲ûסȵ޴һ,
+		//ARCͬʱƵ,Ӱӻ֮ǰ׶ȵ
+		CopAdaptiveCache(size_t capacity, size_t sampleRate = 16, size_t window = 1000,
+			CopPolicyKind initial = CopPolicyKind::Arc)
+			:capacity_(capacity)
+			, sampleRate_(std::max<size_t>(1, std::min(sampleRate, capacity / kMinShadowCapacity)))
+			, window_(std::max<size_t>(1, window))
+			, current_(initial)
+			, live_(makePolicy<Value>(initial, capacity))
+			, drainLeft_(0)
+			, sampled_(0)
+		{
+			size_t shadowCapacity = std::max<size_t>(1, capacity / sampleRate_);
+			for (int i = 0; i < kPolicyCount; ++i)
+			{
+				shadows_[i] = makePolicy<char>(static_cast<CopPolicyKind>(i), shadowCapacity);
+				shadowHits_[i] = 0;
+			}
+		}
+
+		~CopAdaptiveCache() override = default;
+
+		void put(Key key, Value value) override
+		{
+			std::lock_guard<LockPolicy> lock(mutex_);
+			live_->put(key, value);
+			//ſڼɲеļͬ,֤زɲʱֵ;
+			//¼дɲ,лǰĹ,ᱻлķʳ
+			if (draining_)
+			{
+				Value old;
+				if (draining_->get(key, old))
+					draining_->put(key, value);
+				drainStep();
+			}
+			if (isSampled(key))
+			{
+				for (auto& shadow : shadows_)
+					shadow->put(key, 1);
+			}
+		}
+
+		bool get(Key key, Value& value) override
+		{
+			std::lock_guard<LockPolicy> lock(mutex_);
+			if (isSampled(key))
+				simulate(key);
+
+			if (live_->get(key, value))
+				return true;
+			if (draining_)
+			{
+				if (!draining_->get(key, value))
+					return false;
+				live_->put(key, value);
+				drainStep();
+				return true;
+			}
+			return false;
+		}
+
+		Value get(Key key) override
+		{
+			Value value{};
+			get(key, value);
+			return value;
+		}
+
+		//ǰʹõĲ
+		CopPolicyKind currentPolicy()
+		{
+			std::lock_guard<LockPolicy> lock(mutex_);
+			return current_;
+		}
+
+		//ĳӰӻڵǰͳƴڵд(ÿֱȽϺ)
+		uint64_t shadowHits(CopPolicyKind kind)
+		{
+			std::lock_guard<LockPolicy> lock(mutex_);
+			return shadowHits_[static_cast<int>(kind)];
+		}
+
+	private:
+		static constexpr int kPolicyCount = 4;
+		static constexpr size_t kMinShadowCapacity = 64;//Ӱӻ̫Сʱûвοֵ
+		static constexpr size_t kDrainRounds = 8;//ɲԱ²Ծôдͻز
+
+		template <typename V>
+		static std::unique_ptr<CopCachePolicy<Key, V>> makePolicy(CopPolicyKind kind, size_t capacity)
+		{
+			switch (kind)
+			{
+			case CopPolicyKind::Lfu:
+				return std::unique_ptr<CopCachePolicy<Key, V>>(new CopLfuCache<Key, V, CopNullLock>(static_cast<int>(capacity)));
+			case CopPolicyKind::Arc:
+				return std::unique_ptr<CopCachePolicy<Key, V>>(new CopArcCache<Key, V, CopNullLock>(capacity));
+			case CopPolicyKind::Slru:
+				return std::unique_ptr<CopCachePolicy<Key, V>>(new CopSlruCache<Key, V, CopNullLock>(static_cast<int>(capacity)));
+			case CopPolicyKind::Lru:
+			default:
+				return std::unique_ptr<CopCachePolicy<Key, V>>(new CopLruCache<Key, V, CopNullLock>(static_cast<int>(capacity)));
+			}
+		}
+
+		//ϣ,ͬһǱлǲ
+		bool isSampled(const Key& key) const
+		{
+			if (sampleRate_ == 1)
+				return true;
+			uint64_t h = static_cast<uint64_t>(CopKeyTraits<Key>::hash(key)) * 0x9E3779B97F4A7C15ULL;
+			return (h >> 32) % sampleRate_ == 0;
+		}
+
+		//Ӱӻֻֻputд,ϲԿķͬ;
+		//δʱΪд,͸ĵ÷putһ,ͬһᱻд
+		void simulate(const Key& key)
+		{
+			char flag;
+			for (int i = 0; i < kPolicyCount; ++i)
+			{
+				if (shadows_[i]->get(key, flag))
+					++shadowHits_[i];
+			}
+			if (++sampled_ >= window_)
+				evaluate();
+		}
+
+		//Զڵǰʱл,ڼֲ֮ذڶ
+		void evaluate()
+		{
+			int best = static_cast<int>(current_);
+			for (int i = 0; i < kPolicyCount; ++i)
+			{
+				if (shadowHits_[i] > shadowHits_[best])
+					best = i;
+			}
+			uint64_t currentHits = shadowHits_[static_cast<int>(current_)];
+			if (best != static_cast<int>(current_) && shadowHits_[best] > currentHits + currentHits / 20 + window_ / 100)
+				switchTo(static_cast<CopPolicyKind>(best));
+
+			for (auto& hits : shadowHits_)
+				hits /= 2;
+			sampled_ = 0;
+		}
+
+		void switchTo(CopPolicyKind kind)
+		{
+			draining_ = std::move(live_);
+			live_ = makePolicy<Value>(kind, capacity_);
+			current_ = kind;
+			drainLeft_ = capacity_ * kDrainRounds;
+		}
+
+		void drainStep()
+		{
+			if (drainLeft_ > 0)
+				--drainLeft_;
+			if (drainLeft_ == 0)
+				draining_.reset();
+		}
+
+	private:
+		size_t capacity_;
+		size_t sampleRate_;//
+		size_t window_;//ÿֱȽϵĳ
+		CopPolicyKind current_;//ϲ
+		LockPolicy mutex_;
+
+		std::unique_ptr<CopCachePolicy<Key, Value>> live_;//ϲ
+		std::unique_ptr<CopCachePolicy<Key, Value>> draining_;//лǰľɲ,ſպͷ
+		size_t drainLeft_;//²Իдݲͷžɲ
+
+		std::unique_ptr<CopCachePolicy<Key, char>> shadows_[kPolicyCount];//ѡԵӰӻ
+		uint64_t shadowHits_[kPolicyCount];//Ӱӻд
+		size_t sampled_;//ѳķ
+	};
+
+	//ӦķƬ汾,ÿƬѡ
+	template <typename Key, typename Value, typename LockPolicy = CopMutexLock>
+	class CopHashAdaptiveCache : public CopShardedCache<Key, Value, CopAdaptiveCache<Key, Value, LockPolicy>>
+	{
+	public:
+		CopHashAdaptiveCache(size_t capacity, int sliceNum, size_t sampleRate = 16, size_t window = 1000)
+			:CopShardedCache<Key, Value, CopAdaptiveCache<Key, Value, LockPolicy>>(capacity, sliceNum, sampleRate, window)
+		{}
+	};
+
+}// coloop
@@ -0,0 +1,250 @@
+#pragma once
+
+#include "../CopCachePolicy.h"
+#include "../CopEvictionListener.h"
+#include "../CopLockPolicy.h"
+#include "../CopLockProfiler.h"
+#include "CopArcGhostList.h"
+#include <algorithm>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace CopCache
+{
+	//ԭʵֵARC:湲һc
+	//T1ֻʹһε,T2ʹε,B1/B2ǵ
+	//ĿֵpʾT1Ӧռ,ʱĴС
+	template <typename Key, typename Value, typename LockPolicy = CopMutexLock>
+	class CopArcAdaptiveCache : public CopCachePolicy<Key, Value>
+	{
+	public:
+		using ListenerPtr = std::shared_ptr<CopEvictionListener<Key, Value>>;
+
+		explicit CopArcAdaptiveCache(size_t capacity = 10)
+			:capacity_(capacity)
+			, p_(0)
+			, b1_(capacity)
+			, b2_(2 * capacity)
+		{}
+
+		~CopArcAdaptiveCache() override = default;
+
+		void put(Key key, Value value) override
+		{
+			CopLockOpScope opScope(CopLockOp::Put);
+			CopRemovalBatch<Key, Value> removed;
+			{
+				std::lock_guard<LockPolicy> lock(mutex_);
+				//ܱsetCapacityߵ,Ҫж
+				if (capacity_ == 0)
+					return;
+				auto it = entryMap_.find(key);
+				if (it != entryMap_.end())
+				{
+					//һ:T1T2,ֵƵT2ͷ
+					removals_.push(key, it->second.iter->value, CopRemovalCause::Replaced);
+					it->second.iter->value = value;
+					moveToT2(it->second);
+				}
+				else
+				{
+					insertNew(key, value);
+				}
+				removed = removals_.drain();
+			}
+			removed.deliver();
+		}
+
+		bool get(Key key, Value& value) override
+		{
+			CopLockOpScope opScope(CopLockOp::Get);
+			std::lock_guard<LockPolicy> lock(mutex_);
+			auto it = entryMap_.find(key);
+			if (it == entryMap_.end())
+				return false;
+			//кƵT2ͷ
+			moveToT2(it->second);
+			value = it->second.iter->value;
+			return true;
+		}
+
+		Value get(Key key) override
+		{
+			Value value{};
+			get(key, value);
+			return value;
+		}
+
+		//Ƴ,ֻ֪̭ͨ͸
+		void setRemovalListener(ListenerPtr listener)
+		{
+			std::lock_guard<LockPolicy> lock(mutex_);
+			removals_.setListener(listener);
+		}
+
+		//ߵc;ʱCopResizeStepִREPLACE,ͷ
+		void setCapacity(size_t capacity)
+		{
+			{
+				std::lock_guard<LockPolicy> lock(mutex_);
+				capacity_ = capacity;
+				p_ = std::min(p_, capacity);
+				b1_.setCapacity(capacity);
+				b2_.setCapacity(2 * capacity);
+			}
+			bool done = false;
+			while (!done)
+			{
+				CopRemovalBatch<Key, Value> removed;
+				{
+					std::lock_guard<LockPolicy> lock(mutex_);
+					for (size_t i = 0; i < CopResizeStep && t1_.size() + t2_.size() > capacity_; ++i)
+						replace(false);
+					done = t1_.size() + t2_.size() <= capacity_;
+					removed = removals_.drain();
+				}
+				removed.deliver();
+			}
+		}
+
+		size_t capacity()
+		{
+			std::lock_guard<LockPolicy> lock(mutex_);
+			return capacity_;
+		}
+
+		CopLockStats lockStats() const
+		{
+			return copLockStats(mutex_);
+		}
+
+		//ǰT1Ŀ,ڹ۲Ӧ
+		size_t target()
+		{
+			std::lock_guard<LockPolicy> lock(mutex_);
+			return p_;
+		}
+
+	private:
+		struct Entry
+		{
+			Key key;
+			Value value;
+		};
+		using EntryList = std::list<Entry>;
+
+		struct Location
+		{
+			typename EntryList::iterator iter;
+			bool inT2;
+		};
+
+		//¼뻺,ȸp,ڳռ
+		void insertNew(const Key& key, const Value& value)
+		{
+			if (b1_.remove(key))
+			{
+				//:B1,˵T1̫С,p
+				size_t delta = std::max<size_t>(b2_.size() / (b1_.size() + 1), 1);
+				p_ = std::min(capacity_, p_ + delta);
+				if (t1_.size() + t2_.size() >= capacity_)
+					replace(false);
+				insertFront(t2_, key, value, true);
+				return;
+			}
+			if (b2_.remove(key))
+			{
+				//:B2,˵T2̫С,Сp
+				size_t delta = std::max<size_t>(b1_.size() / (b2_.size() + 1), 1);
+				p_ = p_ > delta ? p_ - delta : 0;
+				if (t1_.size() + t2_.size() >= capacity_)
+					replace(true);
+				insertFront(t2_, key, value, true);
+				return;
+			}
+
+			//:ȫδ
+			size_t l1 = t1_.size() + b1_.size();
+			size_t total = l1 + t2_.size() + b2_.size();
+			if (l1 >= capacity_)
+			{
+				if (t1_.size() < capacity_)
+				{
+					b1_.removeOldest();
+					if (t1_.size() + t2_.size() >= capacity_)
+						replace(false);
+				}
+				else
+				{
+					//B1ΪʱT1ռ,ֱӶT1ɵ
+					evictTail(t1_, CopRemovalCause::Capacity);
+				}
+			}
+			else if (total >= capacity_)
+			{
+				if (total >= 2 * capacity_)
+					b2_.removeOldest();
+				if (t1_.size() + t2_.size() >= capacity_)
+					replace(false);
+			}
+			insertFront(t1_, key, value, false);
+		}
+
+		//ĿֵpT1T2̭һݵӦ
+		void replace(bool hitInB2)
+		{
+			if (!t1_.empty() && (t1_.size() > p_ || (hitInB2 && t1_.size() == p_)))
+			{
+				b1_.add(t1_.back().key);
+				evictTail(t1_, CopRemovalCause::Capacity);
+			}
+			else if (!t2_.empty())
+			{
+				b2_.add(t2_.back().key);
+				evictTail(t2_, CopRemovalCause::Capacity);
+			}
+			else
+			{
+				b1_.add(t1_.back().key);
+				evictTail(t1_, CopRemovalCause::Capacity);
+			}
+		}
+
+		void moveToT2(Location& location)
+		{
+			EntryList& from = location.inT2 ? t2_ : t1_;
+			t2_.splice(t2_.begin(), from, location.iter);
+			location.inT2 = true;
+		}
+
+		void insertFront(EntryList& list, const Key& key, const Value& value, bool inT2)
+		{
+			list.push_front({ key, value });
+			entryMap_[key] = { list.begin(), inT2 };
+		}
+
+		void evictTail(EntryList& list, CopRemovalCause cause)
+		{
+			copLockNote(CopLockOp::Evict);
+			Entry& victim = list.back();
+			removals_.push(victim.key, victim.value, cause);
+			entryMap_.erase(victim.key);
+			list.pop_back();
+		}
+
+	private:
+		size_t capacity_;//c
+		size_t p_;//T1Ŀ
+		LockPolicy mutex_;//,ģ
+
+		EntryList t1_;//ֻһ
+		EntryList t2_;//ʶ
+		ArcGhostList<Key> b1_;//T1
+		ArcGhostList<Key> b2_;//T2
+		std::unordered_map<Key, Location> entryMap_;
+		CopRemovalQueue<Key, Value> removals_;
+	};
+
+}// coloop
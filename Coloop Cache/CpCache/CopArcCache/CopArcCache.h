@@ -4,11 +4,15 @@
 #include"../CopCachePolicy.h"
 #include"CopArcLruPart.h"
 #include"CopArcLfuPart.h"
+#include<algorithm>
+#include<atomic>
 #include<memory>
+#include<mutex>
 
 namespace CopCache
 {
-	template <typename Key,typename Value>
+	//LockPolicyͬʱlrulfu;ʹCopProfiledLockʱlockStats()ϲͳ
+	template <typename Key,typename Value,typename LockPolicy = CopMutexLock>
 	class CopArcCache : public CopCachePolicy <Key, Value>
 	{
 	public:
@@ -16,8 +20,8 @@ namespace CopCache
 		
 			:capacity_(capacity)
 			, transformThreshold_(transformThreshold)
-			,lruPart_(std::make_unique<ArcLruPart<Key,Value>> (capacity,transformThreshold))
-			,lfuPart_(std::make_unique<ArcLfuPart<Key,Value>>(capacity,transformThreshold))
+			,lruPart_(std::make_unique<ArcLruPart<Key,Value,LockPolicy>> (capacity,transformThreshold))
+			,lfuPart_(std::make_unique<ArcLfuPart<Key,Value,LockPolicy>>(capacity,transformThreshold))
 		{}
 
 		~CopArcCache() override = default;
@@ -31,9 +35,11 @@ namespace CopCache
 			//ڶл棬lfuҲڸݣ¸ݣlruɷ(putиºͷ)
 			if (!inGhost)
 			{
-				if (lruPart_->put(key, value))
+				//ֶиüʱֻlruַ֪ͨ
+				bool replaced = false;
+				if (lruPart_->put(key, value, &replaced))
 				{
-					lfuPart_->put(key, value);
+					lfuPart_->put(key, value, !replaced);
 				}
 			}
 
@@ -56,11 +62,44 @@ namespace CopCache
 				//lruĸýڵڷʱתֵʱҪlfu
 				if (shouldTransform)
 				{
-					lfuPart_->put(key, value);
+					//ֵûб仯,Ǹ
+					lfuPart_->put(key, value, false);
 				}
 				return true;
 			}
-			return lfuPart_->get(key, value);
+			if (lfuPart_->get(key, value))
+				return true;
+
+			//ֶδʱļ,·뻺
+			if (victimTier_ && victimTier_->take(key, value))
+			{
+				put(key, value);
+				return true;
+			}
+			return false;
+		}
+
+		//Ƴ,֪̭ͨ͸;ͬһͬʱlrulfu,
+		//ֻдһ̭һҲٳʱ֪̭ͨ,һθֻ֪ͨһ
+		void setRemovalListener(std::shared_ptr<CopEvictionListener<Key, Value>> listener)
+		{
+			listener_ = listener;
+			if (!listener)
+			{
+				lruPart_->setRemovalListener(nullptr);
+				lfuPart_->setRemovalListener(nullptr);
+				return;
+			}
+			lruPart_->setRemovalListener(std::make_shared<PartListener>(this, true));
+			lfuPart_->setRemovalListener(std::make_shared<PartListener>(this, false));
+		}
+
+		//öļ,lrulfṷݶд
+		void setVictimTier(std::shared_ptr<CopFileTier<Key, Value>> tier)
+		{
+			victimTier_ = tier;
+			lruPart_->setVictimTier(tier);
+			lfuPart_->setVictimTier(tier);
 		}
 
 		Value get(Key key) override
@@ -70,8 +109,72 @@ namespace CopCache
 			return value;
 		}
 
+		//ߵc:ְǰı2c,c
+		//ڴȺ̨̲߳,resizeMutex_л
+		void setCapacity(size_t capacity)
+		{
+			std::lock_guard<std::mutex> lock(resizeMutex_);
+			size_t lruCapacity = lruPart_->capacity();
+			size_t total = lruCapacity + lfuPart_->capacity();
+			size_t newLru = total > 0 ? static_cast<size_t>(static_cast<double>(lruCapacity) * 2 * capacity / total) : capacity;
+			newLru = std::min(newLru, 2 * capacity);
+			//Сһȵ,ֵݳԤ
+			if (newLru < lruCapacity)
+			{
+				lruPart_->setCapacity(newLru, capacity);
+				lfuPart_->setCapacity(2 * capacity - newLru, capacity);
+			}
+			else
+			{
+				lfuPart_->setCapacity(2 * capacity - newLru, capacity);
+				lruPart_->setCapacity(newLru, capacity);
+			}
+			capacity_.store(capacity, std::memory_order_relaxed);
+		}
+
+		size_t capacity() const { return capacity_.load(std::memory_order_relaxed); }
+
+		CopLockStats lockStats() const
+		{
+			CopLockStats stats = lruPart_->lockStats();
+			copMergeLockStats(stats, lfuPart_->lockStats());
+			return stats;
+		}
+
 
 	private:
+		//תֵ֪ͨ,̭֪ͨ˵һԳеļ
+		class PartListener : public CopEvictionListener<Key, Value>
+		{
+		public:
+			PartListener(CopArcCache* owner, bool fromLru)
+				:owner_(owner), fromLru_(fromLru)
+			{}
+
+			void onRemoval(const std::vector<CopRemovalNotice<Key, Value>>& notices) override
+			{
+				std::vector<CopRemovalNotice<Key, Value>> filtered;
+				for (const auto& notice : notices)
+				{
+					if (notice.cause == CopRemovalCause::Capacity)
+					{
+						bool stillCached = fromLru_ ? owner_->lfuPart_->contains(notice.key)
+							: owner_->lruPart_->contains(notice.key);
+						if (stillCached)
+							continue;
+					}
+					filtered.push_back(notice);
+				}
+				auto listener = owner_->listener_;
+				if (listener && !filtered.empty())
+					listener->onRemoval(filtered);
+			}
+
+		private:
+			CopArcCache* owner_;
+			bool fromLru_;
+		};
+
 		//黺棬۲黺
 		bool checkGhostCaches(Key key)
 		{
@@ -100,10 +203,13 @@ namespace CopCache
 
 
 	private:
-		size_t capacity_;
+		std::atomic<size_t> capacity_;
 		size_t transformThreshold_;
-		std::unique_ptr<ArcLruPart<Key, Value>> lruPart_;
-		std::unique_ptr<ArcLfuPart<Key, Value>> lfuPart_;
+		std::unique_ptr<ArcLruPart<Key, Value, LockPolicy>> lruPart_;
+		std::unique_ptr<ArcLfuPart<Key, Value, LockPolicy>> lfuPart_;
+		std::shared_ptr<CopFileTier<Key, Value>> victimTier_;//ļ
+		std::shared_ptr<CopEvictionListener<Key, Value>> listener_;//ûõƳ
+		std::mutex resizeMutex_;//лsetCapacity
 
 
 	};
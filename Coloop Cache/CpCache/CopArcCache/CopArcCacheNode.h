@@ -33,8 +33,8 @@ namespace CopCache {
 		void incrementAccessCount() { ++accessCount_; }
 
 		//lrulfuΪԪ࣬ڷʽڵ
-		template <typename K, typename V> friend class ArcLruPart;
-		template <typename K, typename V> friend class ArcLfuPart;
+		template <typename K, typename V, typename L> friend class ArcLruPart;
+		template <typename K, typename V, typename L> friend class ArcLfuPart;
 
 	};
 
@@ -0,0 +1,244 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace CopCache
+{
+	//ָֻƵ,ڵ黺
+	//ζа̭˳¼24λָ,ѰַΪԱ
+	//λ32λ:24λָ,1λЧ,7λָڻеĳִ
+	//ÿԼռ ζ4.5ֽ + ˱6~12ֽ
+	template <typename Key>
+	class ArcGhostList
+	{
+	public:
+		explicit ArcGhostList(size_t capacity)
+			:capacity_(capacity)
+			, ring_(capacity + capacity / 8 + 1, 0)
+			, ringHead_(0)
+			, ringSize_(0)
+			, liveCount_(0)
+		{
+			size_t tableSize = 8;
+			while (tableSize < ring_.size() * 4 / 3 + 1)
+				tableSize <<= 1;
+			table_.assign(tableSize, 0);
+		}
+
+		//:Ƴtrue
+		bool remove(const Key& key)
+		{
+			size_t pos;
+			if (!findSlot(fingerprint(key), pos) || !(table_[pos] & kLiveBit))
+				return false;
+			//ֻЧ,еľɼ¼ڳӻʱ
+			table_[pos] &= ~kLiveBit;
+			--liveCount_;
+			return true;
+		}
+
+		bool contains(const Key& key) const
+		{
+			size_t pos;
+			return findSlot(fingerprint(key), pos) && (table_[pos] & kLiveBit);
+		}
+
+		//һ̭ļ,ʱɵЧ
+		void add(const Key& key)
+		{
+			if (capacity_ == 0)
+				return;
+			uint32_t fp = fingerprint(key);
+			size_t pos;
+			bool found = findSlot(fp, pos);
+			//ΪƵλ,ɼ¼ڳʱֻټ
+			if (!(found && (table_[pos] & kLiveBit)))
+			{
+				while (liveCount_ >= capacity_)
+					popOldest();
+			}
+			if (ringSize_ == ring_.size())
+				compactRing();
+			found = findSlot(fp, pos);
+			if (found && countOf(table_[pos]) == kMaxCount)
+			{
+				compactRing();
+				found = findSlot(fp, pos);
+			}
+
+			if (found)
+			{
+				if (!(table_[pos] & kLiveBit))
+					++liveCount_;
+				table_[pos] = (table_[pos] | kLiveBit) + 1;
+			}
+			else
+			{
+				table_[pos] = (fp << kFpShift) | kLiveBit | 1;
+				++liveCount_;
+			}
+			ring_[(ringHead_ + ringSize_) % ring_.size()] = fp;
+			++ringSize_;
+		}
+
+		//ɵһЧ
+		void removeOldest()
+		{
+			size_t before = liveCount_;
+			while (ringSize_ > 0 && liveCount_ == before)
+				popOldest();
+		}
+
+		//:ȶ,ٰؽζк͹˱
+		void setCapacity(size_t capacity)
+		{
+			while (liveCount_ > capacity)
+				removeOldest();
+			compactRing();
+			std::vector<uint32_t> kept(ring_.begin(), ring_.begin() + ringSize_);
+
+			capacity_ = capacity;
+			ring_.assign(capacity + capacity / 8 + 1, 0);
+			size_t tableSize = 8;
+			while (tableSize < ring_.size() * 4 / 3 + 1)
+				tableSize <<= 1;
+			table_.assign(tableSize, 0);
+			//ÿָֻһҶЧ
+			for (size_t i = 0; i < kept.size(); ++i)
+			{
+				size_t pos;
+				findSlot(kept[i], pos);
+				table_[pos] = (kept[i] << kFpShift) | kLiveBit | 1;
+				ring_[i] = kept[i];
+			}
+			ringHead_ = 0;
+			ringSize_ = kept.size();
+			liveCount_ = kept.size();
+		}
+
+		size_t size() const { return liveCount_; }
+		size_t capacity() const { return capacity_; }
+
+	private:
+		static constexpr uint32_t kFpShift = 8;
+		static constexpr uint32_t kLiveBit = 0x80;
+		static constexpr uint32_t kCountMask = 0x7f;
+		static constexpr uint32_t kMaxCount = 0x7f;
+
+		static uint32_t countOf(uint32_t slot) { return slot & kCountMask; }
+		static uint32_t fpOf(uint32_t slot) { return slot >> kFpShift; }
+
+		//24λָ,ȴɢstd::hashĽ(std::hashͨǺӳ)
+		static uint32_t fingerprint(const Key& key)
+		{
+			uint64_t h = std::hash<Key>()(key);
+			h ^= h >> 33;
+			h *= 0xff51afd7ed558ccdULL;
+			h ^= h >> 33;
+			h *= 0xc4ceb9fe1a85ec53ULL;
+			h ^= h >> 33;
+			uint32_t fp = static_cast<uint32_t>(h) & 0xffffff;
+			return fp == 0 ? 1 : fp;
+		}
+
+		size_t homeSlot(uint32_t fp) const
+		{
+			return (static_cast<size_t>(fp) * 0x9E3779B1u) & (table_.size() - 1);
+		}
+
+		//̽,ҵtrue;ҲʱposΪɲĿղ
+		bool findSlot(uint32_t fp, size_t& pos) const
+		{
+			size_t mask = table_.size() - 1;
+			pos = homeSlot(fp);
+			while (table_[pos] != 0)
+			{
+				if (fpOf(table_[pos]) == fp)
+					return true;
+				pos = (pos + 1) & mask;
+			}
+			return false;
+		}
+
+		//ɾ,֤̽Ͽ
+		void eraseSlot(size_t pos)
+		{
+			size_t mask = table_.size() - 1;
+			size_t next = (pos + 1) & mask;
+			while (table_[next] != 0)
+			{
+				size_t home = homeSlot(fpOf(table_[next]));
+				//nextλò(pos, next]ʱǰ
+				if (((next - home) & mask) >= ((next - pos) & mask))
+				{
+					table_[pos] = table_[next];
+					pos = next;
+				}
+				next = (next + 1) & mask;
+			}
+			table_[pos] = 0;
+		}
+
+		//һ¼,һγЧĲ㶪һ
+		void popOldest()
+		{
+			if (ringSize_ == 0)
+				return;
+			uint32_t fp = ring_[ringHead_];
+			ring_[ringHead_] = 0;
+			ringHead_ = (ringHead_ + 1) % ring_.size();
+			--ringSize_;
+
+			size_t pos;
+			if (!findSlot(fp, pos))
+				return;
+			if (countOf(table_[pos]) > 1)
+			{
+				--table_[pos];
+				return;
+			}
+			if (table_[pos] & kLiveBit)
+				--liveCount_;
+			eraseSlot(pos);
+		}
+
+		//ζ:ֻÿЧָƵһγ
+		void compactRing()
+		{
+			std::vector<uint32_t> kept;
+			kept.reserve(liveCount_);
+			for (size_t i = 0; i < ringSize_; ++i)
+			{
+				uint32_t fp = ring_[(ringHead_ + i) % ring_.size()];
+				size_t pos;
+				if (!findSlot(fp, pos))
+					continue;
+				if (countOf(table_[pos]) > 1)
+				{
+					--table_[pos];
+					continue;
+				}
+				if (table_[pos] & kLiveBit)
+					kept.push_back(fp);
+				else
+					eraseSlot(pos);
+			}
+			std::fill(ring_.begin(), ring_.end(), 0);
+			std::copy(kept.begin(), kept.end(), ring_.begin());
+			ringHead_ = 0;
+			ringSize_ = kept.size();
+		}
+
+	private:
+		size_t capacity_;//Ч
+		std::vector<uint32_t> ring_;//̭˳еָ
+		size_t ringHead_;
+		size_t ringSize_;
+		size_t liveCount_;//Ч
+		std::vector<uint32_t> table_;//ָƹ˱
+	};
+
+}// coloop
@@ -1,5 +1,12 @@
 #pragma once
+# include "../CopCachePolicy.h"
 # include "CopArcCacheNode.h"
+# include "CopArcGhostList.h"
+# include "../CopFileTier.h"
+# include "../CopEvictionListener.h"
+# include "../CopLockPolicy.h"
+# include "../CopLockProfiler.h"
+#include <shared_mutex>
 # include <unordered_map>
 #include <map>
 #include <mutex>
@@ -7,7 +14,7 @@
 
 namespace CopCache
 {
-	template <typename Key,typename Value>
+	template <typename Key,typename Value,typename LockPolicy = CopMutexLock>
 	class ArcLfuPart
 	{
 	public:
@@ -16,34 +23,46 @@ namespace CopCache
 		using NodePtr = std::shared_ptr<NodeType>;
 		using NodeMap = std::unordered_map <Key, NodePtr>;//ڵϣ
 		using FreqMap = std::map<size_t, std::list<NodePtr>>;//Ƶϣ
+		using TierPtr = std::shared_ptr<CopFileTier<Key, Value>>;
+		using ListenerPtr = std::shared_ptr<CopEvictionListener<Key, Value>>;
 
 		explicit ArcLfuPart(size_t capacity, size_t transformThreshold)
 			:capacity_(capacity)
-			, ghostCpacity_(capacity)
 			,transformThreshold_(transformThreshold)
 			,minFreq_(0)
-		{
-			intializeLists();
-		}
+			,ghost_(capacity)
+		{}
 		
-		bool put(Key key, Value value)
+		//notifyReplacedΪfalseʱеֵ֪ͨ,һѾ֪ͨͬһд
+		bool put(Key key, Value value, bool notifyReplaced = true)
 		{
-			if (capacity_ == 0)
-				return false;
-
-			std::lock_guard<std::mutex> lock(mutex_);
-			auto it = mainCache_.find(key);
-			if (it != mainCache_.end())
+			CopLockOpScope opScope(CopLockOp::Put);
+			CopRemovalBatch<Key, Value> removed;
+			bool result;
 			{
-				return updateExistingNode(it->second, value);
-
+				std::lock_guard<LockPolicy> lock(mutex_);
+				//ᱻһֲ,Ҫж
+				if (capacity_ == 0)
+					return false;
+				auto it = mainCache_.find(key);
+				if (it != mainCache_.end())
+				{
+					if (notifyReplaced)
+						removals_.push(key, it->second->getValue(), CopRemovalCause::Replaced);
+					result = updateExistingNode(it->second, value);
+				}
+				else
+					result = addNewNode(key, value);
+				removed = removals_.drain();
 			}
-			return addNewNode(key, value);
+			removed.deliver();
+			return result;
 		}
 
 		bool get(Key key, Value& value)
 		{
-			std::lock_guard<std::mutex> lock(mutex_);
+			CopLockOpScope opScope(CopLockOp::Get);
+			std::lock_guard<LockPolicy> lock(mutex_);
 			auto it = mainCache_.find(key);
 			if (it != mainCache_.end()){
 				//ʺҪƵ
@@ -57,44 +76,91 @@ namespace CopCache
 
 		bool checkGhost(Key key)
 		{
-			auto it = ghostCache_.find(key);
-			if (it != ghostCache_.end())
+			std::lock_guard<LockPolicy> lock(mutex_);
+			return ghost_.remove(key);
+		}
+
+
+		//öļ
+		void setVictimTier(TierPtr tier)
+		{
+			std::lock_guard<LockPolicy> lock(mutex_);
+			victimTier_ = tier;
+		}
+
+		//Ƴ,֪̭ͨ͸
+		void setRemovalListener(ListenerPtr listener)
+		{
+			std::lock_guard<LockPolicy> lock(mutex_);
+			removals_.setListener(listener);
+		}
+
+		//жǷڸü,ӰƵ
+		bool contains(Key key)
+		{
+			std::shared_lock<LockPolicy> lock(mutex_);
+			return mainCache_.find(key) != mainCache_.end();
+		}
+
+		CopLockStats lockStats() const
+		{
+			return copLockStats(mutex_);
+		}
+
+		size_t capacity()
+		{
+			std::shared_lock<LockPolicy> lock(mutex_);
+			return capacity_;
+		}
+
+		//ߵ,ʱCopResizeStep̭,ͷ
+		void setCapacity(size_t capacity, size_t ghostCapacity)
+		{
 			{
-				removeFromGhost(it->second);
-				ghostCache_.erase(it);
-				return true;
+				std::lock_guard<LockPolicy> lock(mutex_);
+				capacity_ = capacity;
+				ghost_.setCapacity(ghostCapacity);
+			}
+			bool done = false;
+			while (!done)
+			{
+				CopRemovalBatch<Key, Value> removed;
+				{
+					std::lock_guard<LockPolicy> lock(mutex_);
+					for (size_t i = 0; i < CopResizeStep && mainCache_.size() > capacity_; ++i)
+						evictLeastFrequent();
+					done = mainCache_.size() <= capacity_;
+					removed = removals_.drain();
+				}
+				removed.deliver();
 			}
-			return false;
 		}
 
-
 		void increaseCapacity() {
+			std::lock_guard<LockPolicy> lock(mutex_);
 			++capacity_;
 		}
 
 		bool decreaseCapacity()
 		{
-			if (capacity_ <= 0)
-				return false;
-			if (mainCache_.size() == capacity_)
+			CopRemovalBatch<Key, Value> removed;
 			{
-				evictLeastFrequent();
+				std::lock_guard<LockPolicy> lock(mutex_);
+				if (capacity_ <= 0)
+					return false;
+				if (mainCache_.size() == capacity_)
+				{
+					evictLeastFrequent();
+				}
+				--capacity_;
+				removed = removals_.drain();
 			}
-			--capacity_;
+			removed.deliver();
 			return true;
 		}
 
 
 	private:
-		void intializeLists() 
-		{
-			ghostHead_ = std::make_shared <NodeType>();
-			ghostTail_ = std::make_shared <NodeType>();
-
-			ghostHead_->next_ = ghostTail_;
-			ghostTail_->prev_ = ghostHead_;
-		}
-
 		bool updateExistingNode(NodePtr node, const Value& value)
 		{
 			node->setValue(value);
@@ -113,7 +179,7 @@ namespace CopCache
 
 			//½ڵӵƵΪ1
 			//ڣҪһƵ1
-			if (freqMap_.find(key) == freqMap_.end())
+			if (freqMap_.find(1) == freqMap_.end())
 			{
 				freqMap_[1] = std::list<NodePtr>();
 			}
@@ -164,6 +230,7 @@ namespace CopCache
 			auto& minFreqList = freqMap_[minFreq_];
 			if (minFreqList.empty())
 				return;
+			copLockNote(CopLockOp::Evict);
 
 			//ƳƵʹõĽڵ,ҴʱҪҪɾĽڵ㣬Ҫ黺
 			NodePtr deleteNode = minFreqList.front();
@@ -180,65 +247,34 @@ namespace CopCache
 				}
 			}
 
-			//ڵ黺
-			if (ghostCache_.size() >= ghostCpacity_)
-			{
-				removeOldestGhost();
+			removals_.push(deleteNode->getKey(), deleteNode->getValue(), CopRemovalCause::Capacity);
 
-			}
-			addToGhost(deleteNode);
+			//ļʱ,̭³ļ
+			if (victimTier_)
+				victimTier_->store(deleteNode->getKey(), deleteNode->getValue());
+
+			//ָƷ,ʱԶɵָ
+			ghost_.add(deleteNode->getKey());
 			
 			//󽫸ýڵƳ
 			mainCache_.erase(deleteNode->getKey());
 
 		}
 
-		void removeFromGhost(NodePtr node)
-		{
-			node->prev_->next_ = node->next_;
-			node->next_->prev_ = node->prev_;
-
-		}
-
-		void addToGhost(NodePtr node)
-		{
-			node->next_ = ghostTail_;
-			node->prev_ = ghostTail_->prev_;
-			ghostTail_->prev_->next_ =node;
-			ghostTail_->prev_ =node;
-
-			ghostCache_[node->getKey()] =node;
-		}
-
-		void removeOldestGhost()
-		{
-			NodePtr oldestGhost = ghostHead_->next_;
-			if (oldestGhost != ghostTail_)
-			{
-				removeFromGhost(oldestGhost);
-				ghostCache_.erase(oldestGhost->getKey());
-
-			}
-		}
-		
-
-
 	private:
 
 		size_t capacity_;
-		size_t ghostCpacity_;
 		size_t transformThreshold_;
 		size_t minFreq_;
-		std::mutex mutex_;
+		LockPolicy mutex_;//,ģ
+		TierPtr victimTier_;//ļ
+		CopRemovalQueue<Key, Value> removals_;//ڼ̭֪ܵͨ
 
 		NodeMap mainCache_;//棬ҲǼֵڵϣ
-		NodeMap ghostCache_;//黺
+		ArcGhostList<Key> ghost_;//ָֻƵ
 		FreqMap freqMap_;//Ƶϣ洢ƵӦƵӳϵ
 
 		//ﲻƵλڱڵԭǣƵϣԸƵεȵӦӦԴfront
-
-		NodePtr ghostHead_;
-		NodePtr ghostTail_;
 	};
 
 } // coloop
\ No newline at end of file
@@ -1,11 +1,18 @@
 #pragma once
 
+#include "../CopCachePolicy.h"
 #include "CopArcCacheNode.h"
+#include "CopArcGhostList.h"
+#include "../CopFileTier.h"
+#include "../CopEvictionListener.h"
+#include "../CopLockPolicy.h"
+#include "../CopLockProfiler.h"
+#include <shared_mutex>
 #include <unordered_map>
 #include <mutex>
 
 namespace CopCache {
-	template <typename Key,typename Value>
+	template <typename Key,typename Value,typename LockPolicy = CopMutexLock>
 	class ArcLruPart
 	{
 	public:
@@ -13,32 +20,46 @@ namespace CopCache {
 		using NodeType = ArcNode<Key, Value>;
 		using NodePtr = std::shared_ptr<NodeType>;
 		using NodeMap = std::unordered_map<Key, NodePtr>;
+		using TierPtr = std::shared_ptr<CopFileTier<Key, Value>>;
+		using ListenerPtr = std::shared_ptr<CopEvictionListener<Key, Value>>;
 
 		explicit ArcLruPart(size_t capacity, size_t transformThreshold) 
 			:capacity_(capacity)
-			,ghostCapacity_(capacity)
 			,transformThreshold_(transformThreshold)
+			,ghost_(capacity)
 		{
 			initializeLists();
 		}
 
-		bool put(Key key, Value value)
+		//replacedǿʱǷ񸲸еֵ
+		bool put(Key key, Value value, bool* replaced = nullptr)
 		{
-			if (capacity_ == 0) return false;
-
-			//߳
-			std::lock_guard <std::mutex> lock(mutex_);
-			auto it = MainCache_.find(key);
-			if (it != MainCache_.end()) {
-				return updateExistingNode(it->second, value);
+			CopLockOpScope opScope(CopLockOp::Put);
+			CopRemovalBatch<Key, Value> removed;
+			bool result;
+			{
+				//߳
+				std::lock_guard<LockPolicy> lock(mutex_);
+				//ᱻһֲ,Ҫж
+				if (capacity_ == 0) return false;
+				auto it = MainCache_.find(key);
+				if (replaced)
+					*replaced = it != MainCache_.end();
+				if (it != MainCache_.end())
+					result = updateExistingNode(it->second, value);
+				else
+					result = addNewNode(key, value);
+				removed = removals_.drain();
 			}
-			return addNewNode(key, value);
+			removed.deliver();
+			return result;
 		}
 
 		// ֵ  Ƿﵽתֵж
 		bool get(Key key, Value& value, bool& shouldTransform)
 		{
-			std::lock_guard <std::mutex> lock(mutex_);
+			CopLockOpScope opScope(CopLockOp::Get);
+			std::lock_guard<LockPolicy> lock(mutex_);
 
 			auto it = MainCache_.find(key);
 			if (it != MainCache_.end())
@@ -54,29 +75,88 @@ namespace CopCache {
 		//黺Ƿڶڽڵ
 		bool checkGhost(Key key)
 		{
-			auto it = GhostCache_.find(key);
-			if (it != GhostCache_.end())
+			std::lock_guard<LockPolicy> lock(mutex_);
+			return ghost_.remove(key);
+		}
+
+		//öļ
+		void setVictimTier(TierPtr tier)
+		{
+			std::lock_guard<LockPolicy> lock(mutex_);
+			victimTier_ = tier;
+		}
+
+		//Ƴ,֪̭ͨ͸
+		void setRemovalListener(ListenerPtr listener)
+		{
+			std::lock_guard<LockPolicy> lock(mutex_);
+			removals_.setListener(listener);
+		}
+
+		//жǷڸü,Ӱ˳
+		bool contains(Key key)
+		{
+			std::shared_lock<LockPolicy> lock(mutex_);
+			return MainCache_.find(key) != MainCache_.end();
+		}
+
+		CopLockStats lockStats() const
+		{
+			return copLockStats(mutex_);
+		}
+
+		size_t capacity()
+		{
+			std::shared_lock<LockPolicy> lock(mutex_);
+			return capacity_;
+		}
+
+		//ߵ,ʱCopResizeStep̭,ͷ
+		void setCapacity(size_t capacity, size_t ghostCapacity)
+		{
 			{
-				removeFromGhost(it->second);
-				GhostCache_.erase(it);
-				return true;
+				std::lock_guard<LockPolicy> lock(mutex_);
+				capacity_ = capacity;
+				ghost_.setCapacity(ghostCapacity);
+			}
+			bool done = false;
+			while (!done)
+			{
+				CopRemovalBatch<Key, Value> removed;
+				{
+					std::lock_guard<LockPolicy> lock(mutex_);
+					for (size_t i = 0; i < CopResizeStep && MainCache_.size() > capacity_; ++i)
+						evictLeastRecent();
+					done = MainCache_.size() <= capacity_;
+					removed = removals_.drain();
+				}
+				removed.deliver();
 			}
-			return false;
 		}
 
 		//ӻ
-		void increaseCapacity() { ++capacity_; }
+		void increaseCapacity()
+		{
+			std::lock_guard<LockPolicy> lock(mutex_);
+			++capacity_;
+		}
 
 		// ٻ
 		bool decreaseCapacity()
 		{
-			if (capacity_ <= 0) return false;
-			//ʱҪһλ
-			if (MainCache_.size() == capacity_)
+			CopRemovalBatch<Key, Value> removed;
 			{
-				evictLeastRecent();
+				std::lock_guard<LockPolicy> lock(mutex_);
+				if (capacity_ <= 0) return false;
+				//ʱҪһλ
+				if (MainCache_.size() == capacity_)
+				{
+					evictLeastRecent();
+				}
+				--capacity_;
+				removed = removals_.drain();
 			}
-			--capacity_;
+			removed.deliver();
 			return true;
 		}
 
@@ -90,17 +170,12 @@ namespace CopCache {
 			mainTail_ = std::make_shared<NodeType>();
 			mainHead_->next_ = mainTail_;
 			mainTail_->prev_ = mainHead_;
-
-			//
-			ghostHead_ = std::make_shared<NodeType>();
-			ghostTail_ = std::make_shared<NodeType>();
-			ghostHead_->next_ = ghostTail_;
-			ghostTail_->prev_ = ghostHead_;
 		}
 
 		//ڻеֵ
 		bool updateExistingNode(NodePtr node, const Value& value) 
 		{
+			removals_.push(node->getKey(), node->getValue(), CopRemovalCause::Replaced);
 			node->setValue(value);
 			moveToFront(node);
 			return true;
@@ -159,17 +234,18 @@ namespace CopCache {
 			//Ϊ
 			if (leastRecent == mainHead_)
 				return;
+			copLockNote(CopLockOp::Evict);
 			
 			//Ƴ
 			removeFromMain(leastRecent);
+			removals_.push(leastRecent->getKey(), leastRecent->getValue(), CopRemovalCause::Capacity);
 
-			//Ƴڵӵ黺棬ͬķʽ
-			if (GhostCache_.size() >= ghostCapacity_)
-			{
-				removeOldestGhost();
-			}
+			//ļʱ,̭³ļ
+			if (victimTier_)
+				victimTier_->store(leastRecent->getKey(), leastRecent->getValue());
 
-			addToGhost(leastRecent);
+			//ֻ¼ָ,ʱԶɵָ
+			ghost_.add(leastRecent->getKey());
 
 			//ӳɾڽڵ
 			MainCache_.erase(leastRecent->getKey());
@@ -183,62 +259,23 @@ namespace CopCache {
 
 		}
 
-		//黺ƳдֻΪ˺
-		void removeFromGhost(NodePtr node)
-		{
-			node->prev_->next_ = node->next_;
-			node->next_->prev_ = node->prev_;
-		}
-
-		// ӵ黺
-		void addToGhost(NodePtr node)
-		{
-			//÷ʴ
-			node->accessCount_=1;
-
-			//ӵ黺ͷ
-			node->next_ = ghostHead_->next_;
-			node->prev_ = ghostHead_;
-			ghostHead_->next_->prev_ = node;
-			ghostHead_->next_ = node;
-
-			//ӵ黺ӳ
-			GhostCache_[node->getKey()] = node;
-		}
-
-		//黺ʹýڵ㣬֮ǰдһ
-		void removeOldestGhost()
-		{
-			NodePtr oldestGhost = ghostTail_->prev_;
-			if (oldestGhost == ghostHead_)
-				return;
-
-			removeFromGhost(oldestGhost);
-			GhostCache_.erase(oldestGhost->getKey());
-		}
-
-
-
 	private:
 
-		size_t ghostCapacity_;
 		size_t capacity_;
 		size_t transformThreshold_;//תֵ
-		std::mutex mutex_;
+		LockPolicy mutex_;//,ģ
+		TierPtr victimTier_;//ļ
+		CopRemovalQueue<Key, Value> removals_;//ڼ̭֪ܵͨ
 
 		//黺
 
 		NodeMap MainCache_;
-		NodeMap GhostCache_;
+		ArcGhostList<Key> ghost_;//ָֻƵ
 
 		//ڱڵָ
 		NodePtr mainHead_;
 		NodePtr mainTail_;
 
-		//ڱڵָ
-		NodePtr ghostHead_;
-		NodePtr ghostTail_;
-
 
 	};
 
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "CopFileTier.h"
+#include "CopKeyTraits.h"
+
+namespace CopCache {
+
+	//˴洢ӿ:дģʽ»水д,δʱӺ˶ȡ
+	//ʵҪб֤̰߳ȫ;ͬһдǴύ,ύݸ
+	template <typename Key, typename Value>
+	class CopBackingStore
+	{
+	public:
+		virtual ~CopBackingStore() {};
+
+		virtual bool load(const Key& key, Value& value) = 0;
+
+		virtual void storeBatch(const std::vector<std::pair<Key, Value>>& batch) = 0;
+	};
+
+	//ļʵֵĲο,߲дģʽ
+	//ֻ׷д־ļ,ڴб¼λõ;ļʱط־ָ
+	//дµľɼ¼,ֻʺϲԺС
+	template <typename Key, typename Value>
+	class CopFileStore : public CopBackingStore<Key, Value>
+	{
+	public:
+		explicit CopFileStore(const std::string& path, size_t batchBytes = 64 * 1024, size_t blockSize = 4096)
+			:log_(batchBytes, blockSize)
+			, blockSize_(blockSize)
+		{
+			uint64_t tail = replay(path);
+			log_.open(path, tail == 0, tail);
+		}
+
+		~CopFileStore() override
+		{
+			log_.close();
+		}
+
+		CopFileStore(const CopFileStore&) = delete;
+		CopFileStore& operator=(const CopFileStore&) = delete;
+
+		bool load(const Key& key, Value& value) override
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			auto it = index_.find(key);
+			if (it == index_.end())
+				return false;
+			std::string record;
+			if (!log_.read(it->second.offset, it->second.length, record))
+				return false;
+			Key ignored;
+			return decodeRecord(record.data(), record.size(), ignored, value);
+		}
+
+		//׷Ӻһ
+		void storeBatch(const std::vector<std::pair<Key, Value>>& batch) override
+		{
+			std::string record;
+			std::lock_guard<std::mutex> lock(mutex_);
+			for (const auto& pair : batch)
+			{
+				record.clear();
+				encodeRecord(pair.first, pair.second, record);
+				uint64_t offset = log_.append(record.data(), record.size());
+				index_[pair.first] = { offset, static_cast<uint32_t>(record.size()) };
+			}
+			log_.flush();
+		}
+
+		size_t size()
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			return index_.size();
+		}
+
+	private:
+		struct IndexEntry
+		{
+			uint64_t offset;
+			uint32_t length;
+		};
+
+		//¼ʽ:[1][][ֵ][][ֵ];־鲹,Ϊ0ʾ
+		static constexpr char kRecordMark = 1;
+		static constexpr size_t kHeader = 1 + 2 * sizeof(uint32_t);
+
+		static void encodeRecord(const Key& key, const Value& value, std::string& out)
+		{
+			std::string keyBytes;
+			std::string valueBytes;
+			CopSerializer<Key>::write(keyBytes, key);
+			CopSerializer<Value>::write(valueBytes, value);
+			uint32_t keyLen = static_cast<uint32_t>(keyBytes.size());
+			uint32_t valueLen = static_cast<uint32_t>(valueBytes.size());
+			out.push_back(kRecordMark);
+			out.append(reinterpret_cast<const char*>(&keyLen), sizeof(keyLen));
+			out.append(reinterpret_cast<const char*>(&valueLen), sizeof(valueLen));
+			out.append(keyBytes);
+			out.append(valueBytes);
+		}
+
+		//ؼ¼ܳ,ݲʱ0
+		static size_t recordLength(const char* data, size_t len)
+		{
+			if (len < kHeader || data[0] != kRecordMark)
+				return 0;
+			uint32_t keyLen = 0;
+			uint32_t valueLen = 0;
+			std::memcpy(&keyLen, data + 1, sizeof(keyLen));
+			std::memcpy(&valueLen, data + 1 + sizeof(keyLen), sizeof(valueLen));
+			size_t total = kHeader + keyLen + valueLen;
+			return total <= len ? total : 0;
+		}
+
+		static bool decodeRecord(const char* data, size_t len, Key& key, Value& value)
+		{
+			size_t total = recordLength(data, len);
+			if (total == 0)
+				return false;
+			uint32_t keyLen = 0;
+			uint32_t valueLen = 0;
+			std::memcpy(&keyLen, data + 1, sizeof(keyLen));
+			std::memcpy(&valueLen, data + 1 + sizeof(keyLen), sizeof(valueLen));
+			return CopSerializer<Key>::read(data + kHeader, keyLen, key)
+				&& CopSerializer<Value>::read(data + kHeader + keyLen, valueLen, value);
+		}
+
+		//˳ɨ־ؽ,һ;־ĩβ
+		uint64_t replay(const std::string& path)
+		{
+			std::ifstream in(path, std::ios::binary);
+			if (!in)
+				return 0;
+			std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+			size_t pos = 0;
+			while (pos < content.size())
+			{
+				size_t total = recordLength(content.data() + pos, content.size() - pos);
+				if (total == 0)
+				{
+					pos = (pos / blockSize_ + 1) * blockSize_;
+					continue;
+				}
+				Key key;
+				Value value;
+				if (decodeRecord(content.data() + pos, total, key, value))
+					index_[key] = { pos, static_cast<uint32_t>(total) };
+				pos += total;
+			}
+			//־ǰд,ļȾǿĩβ
+			return content.size();
+		}
+
+	private:
+		CopLogFile log_;
+		size_t blockSize_;
+		std::unordered_map<Key, IndexEntry> index_;
+		std::mutex mutex_;
+	};
+
+}// coloop
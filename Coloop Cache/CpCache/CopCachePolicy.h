@@ -1,5 +1,9 @@
 #pragma once
+#include <cstddef>
 namespace CopCache {//޶CopCacheֿռ
+
+	//ʱÿ̭Ľڵ,֮ͷ,һݳʱ߳
+	constexpr size_t CopResizeStep = 64;
 	//ģ
 	template <typename Key, typename Value>
 	class CopCachePolicy {//
@@ -17,4 +21,22 @@ namespace CopCache {//
 		virtual Value get(Key key) = 0;
 	};
 
+	//̬:оʱ,޶ƹ麯,get/put·Ա
+	//PolicyҪCopCachePolicyͬ,Ҫ̳
+	template <typename Policy>
+	struct CopStaticDispatch
+	{
+		template <typename Key, typename Value>
+		static void put(Policy& policy, const Key& key, const Value& value)
+		{
+			policy.Policy::put(key, value);
+		}
+
+		template <typename Key, typename Value>
+		static bool get(Policy& policy, const Key& key, Value& value)
+		{
+			return policy.Policy::get(key, value);
+		}
+	};
+
 }// coloop
\ No newline at end of file
@@ -0,0 +1,350 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+
+#include "CopCachePolicy.h"
+#include "CopEvictionListener.h"
+#include "CopKeyTraits.h"
+#include "CopLockPolicy.h"
+#include "CopLockProfiler.h"
+#include "CopShardedCache.h"
+
+namespace CopCache {
+
+	//հLFU:СĿ,ÿݵԪϢѹʮֽ
+	//ݰλ,ֵ8λͼָһ(ṹṹ),
+	//32λλ±shared_ptr;λֻ4ֽ±
+	//log29Ͱ(0,1,2-3,4-7,...,128-255),̭͵ķǿͰβȡ,LFU,
+	//ͬһͰڰ;ƽmaxAverageNumʱȫ,CopLfuCacheϻʽһ
+	//ϻֻ˳ɨյļ±,ýڵ
+	//ֱ֧ǩʧЧļ,ҪЩʱʹCopLfuCache
+	template <typename Key, typename Value, typename LockPolicy = CopMutexLock>
+	class CopCompactLfuCache : public CopCachePolicy<Key, Value>
+	{
+	public:
+		using ListenerPtr = std::shared_ptr<CopEvictionListener<Key, Value>>;
+
+		explicit CopCompactLfuCache(size_t capacity, int maxAverageNum = 10)
+			:capacity_(capacity)
+			, maxAverageNum_(maxAverageNum)
+			, total_(0)
+			, freeHead_(kNil)
+		{
+			std::fill(std::begin(head_), std::end(head_), kNil);
+			std::fill(std::begin(tail_), std::end(tail_), kNil);
+			reserve(capacity);
+		}
+
+		~CopCompactLfuCache() override = default;
+
+		void put(Key key, Value value) override
+		{
+			CopLockOpScope opScope(CopLockOp::Put);
+			CopRemovalBatch<Key, Value> removed;
+			{
+				std::lock_guard<LockPolicy> lock(mutex_);
+				if (capacity_ == 0)
+					return;
+				auto it = index_.find(key);
+				if (it != index_.end())
+				{
+					uint32_t slot = it->second;
+					removals_.push(key, values_[slot], CopRemovalCause::Replaced);
+					values_[slot] = value;
+					touch(slot);
+				}
+				else
+				{
+					if (index_.size() >= capacity_)
+						evictOne();
+					uint32_t slot = allocSlot();
+					keys_[slot] = key;
+					values_[slot] = value;
+					counters_[slot] = 1;
+					++total_;
+					link(slot, bucketOf(1));
+					index_[key] = slot;
+					checkAging();
+				}
+				removed = removals_.drain();
+			}
+			removed.deliver();
+		}
+
+		bool get(Key key, Value& value) override
+		{
+			CopLockOpScope opScope(CopLockOp::Get);
+			std::lock_guard<LockPolicy> lock(mutex_);
+			auto it = index_.find(key);
+			if (it == index_.end())
+				return false;
+			uint32_t slot = it->second;
+			touch(slot);
+			value = values_[slot];
+			return true;
+		}
+
+		Value get(Key key) override
+		{
+			Value value{};
+			get(key, value);
+			return value;
+		}
+
+		void remove(Key key)
+		{
+			CopRemovalBatch<Key, Value> removed;
+			{
+				std::lock_guard<LockPolicy> lock(mutex_);
+				auto it = index_.find(key);
+				if (it != index_.end())
+				{
+					uint32_t slot = it->second;
+					removals_.push(key, values_[slot], CopRemovalCause::Explicit);
+					eraseSlot(slot);
+				}
+				removed = removals_.drain();
+			}
+			removed.deliver();
+		}
+
+		//ֻ:Ӽ
+		bool contains(Key key)
+		{
+			std::shared_lock<LockPolicy> lock(mutex_);
+			return index_.find(key) != index_.end();
+		}
+
+		//ߵ;ʱCopResizeStep̭,ͷ
+		//ݲ黹λڴ,ճĲλ֮д븴
+		void setCapacity(size_t capacity)
+		{
+			{
+				std::lock_guard<LockPolicy> lock(mutex_);
+				capacity_ = capacity;
+				reserve(capacity);
+			}
+			bool done = false;
+			while (!done)
+			{
+				CopRemovalBatch<Key, Value> removed;
+				{
+					std::lock_guard<LockPolicy> lock(mutex_);
+					for (size_t i = 0; i < CopResizeStep && index_.size() > capacity_; ++i)
+						evictOne();
+					done = index_.size() <= capacity_;
+					removed = removals_.drain();
+				}
+				removed.deliver();
+			}
+		}
+
+		size_t capacity()
+		{
+			std::shared_lock<LockPolicy> lock(mutex_);
+			return capacity_;
+		}
+
+		size_t size()
+		{
+			std::shared_lock<LockPolicy> lock(mutex_);
+			return index_.size();
+		}
+
+		//ĳǰļ,ʱΪ0;ڹ۲ϻЧ
+		int frequency(Key key)
+		{
+			std::shared_lock<LockPolicy> lock(mutex_);
+			auto it = index_.find(key);
+			return it == index_.end() ? 0 : counters_[it->second];
+		}
+
+		CopLockStats lockStats() const
+		{
+			return copLockStats(mutex_);
+		}
+
+		void setRemovalListener(ListenerPtr listener)
+		{
+			std::lock_guard<LockPolicy> lock(mutex_);
+			removals_.setListener(listener);
+		}
+
+	private:
+		using Slot = uint32_t;
+		using IndexMap = typename CopKeyTraits<Key>::template MapType<Slot>;
+
+		static constexpr Slot kNil = UINT32_MAX;
+		static constexpr int kBuckets = 9;//8λlog2Ͱ
+		static constexpr uint8_t kCounterMax = UINT8_MAX;
+
+		//cڵͰ:cĶλ
+		static int bucketOf(uint8_t counter)
+		{
+			int bucket = 0;
+			while (counter)
+			{
+				++bucket;
+				counter >>= 1;
+			}
+			return bucket;
+		}
+
+		void reserve(size_t capacity)
+		{
+			keys_.reserve(capacity);
+			values_.reserve(capacity);
+			counters_.reserve(capacity);
+			prev_.reserve(capacity);
+			next_.reserve(capacity);
+		}
+
+		//ȸÿвλ(next_),ڸĩβ׷
+		Slot allocSlot()
+		{
+			if (freeHead_ != kNil)
+			{
+				Slot slot = freeHead_;
+				freeHead_ = next_[slot];
+				return slot;
+			}
+			keys_.emplace_back();
+			values_.emplace_back();
+			counters_.push_back(0);
+			prev_.push_back(kNil);
+			next_.push_back(kNil);
+			return static_cast<Slot>(keys_.size() - 1);
+		}
+
+		void link(Slot slot, int bucket)
+		{
+			prev_[slot] = kNil;
+			next_[slot] = head_[bucket];
+			if (head_[bucket] != kNil)
+				prev_[head_[bucket]] = slot;
+			else
+				tail_[bucket] = slot;
+			head_[bucket] = slot;
+		}
+
+		void unlink(Slot slot, int bucket)
+		{
+			if (prev_[slot] != kNil)
+				next_[prev_[slot]] = next_[slot];
+			else
+				head_[bucket] = next_[slot];
+			if (next_[slot] != kNil)
+				prev_[next_[slot]] = prev_[slot];
+			else
+				tail_[bucket] = prev_[slot];
+		}
+
+		//һ:ͼһ,ƵͰͷ
+		void touch(Slot slot)
+		{
+			uint8_t counter = counters_[slot];
+			unlink(slot, bucketOf(counter));
+			if (counter < kCounterMax)
+			{
+				++counter;
+				++total_;
+				counters_[slot] = counter;
+			}
+			link(slot, bucketOf(counter));
+			checkAging();
+		}
+
+		void eraseSlot(Slot slot)
+		{
+			unlink(slot, bucketOf(counters_[slot]));
+			total_ -= counters_[slot];
+			index_.erase(keys_[slot]);
+			keys_[slot] = Key{};
+			values_[slot] = Value{};//ͷֵеԴ
+			counters_[slot] = 0;
+			next_[slot] = freeHead_;
+			freeHead_ = slot;
+		}
+
+		//̭ͷǿͰβĿ
+		void evictOne()
+		{
+			for (int bucket = 0; bucket < kBuckets; ++bucket)
+			{
+				Slot victim = tail_[bucket];
+				if (victim == kNil)
+					continue;
+				copLockNote(CopLockOp::Evict);
+				removals_.push(keys_[victim], values_[victim], CopRemovalCause::Capacity);
+				eraseSlot(victim);
+				return;
+			}
+		}
+
+		void checkAging()
+		{
+			if (!index_.empty() && total_ / index_.size() > static_cast<uint64_t>(maxAverageNum_))
+				age();
+		}
+
+		//ȫ(Ϊ1)·Ͱ
+		//ӵͰͰÿͰβͷ,Ŀ䵽͵Ͱ,ᱻظ,
+		//ԭȺ˳ĿͰĿ֮ǰ
+		void age()
+		{
+			copLockNote(CopLockOp::Aging);
+			total_ = 0;
+			for (int bucket = 0; bucket < kBuckets; ++bucket)
+			{
+				Slot slot = tail_[bucket];
+				while (slot != kNil)
+				{
+					Slot prev = prev_[slot];
+					uint8_t counter = std::max<uint8_t>(1, counters_[slot] / 2);
+					counters_[slot] = counter;
+					total_ += counter;
+					int target = bucketOf(counter);
+					if (target != bucket)
+					{
+						unlink(slot, bucket);
+						link(slot, target);
+					}
+					slot = prev;
+				}
+			}
+		}
+
+	private:
+		size_t capacity_;
+		int maxAverageNum_;//ƽ,ϻ
+		uint64_t total_;//Ŀ֮
+		LockPolicy mutex_;
+		IndexMap index_;//λ
+		//λ±ʵ
+		std::vector<Key> keys_;
+		std::vector<Value> values_;
+		std::vector<uint8_t> counters_;//8λͼ
+		std::vector<Slot> prev_;//Ͱǰ
+		std::vector<Slot> next_;//Ͱĺ,вλɿ
+		Slot head_[kBuckets];//Ͱʶ
+		Slot tail_[kBuckets];//Ͱδʶ
+		Slot freeHead_;//вλ
+		CopRemovalQueue<Key, Value> removals_;
+	};
+
+	//LFUķƬ汾
+	template <typename Key, typename Value, typename LockPolicy = CopMutexLock>
+	class CopHashCompactLfuCache : public CopShardedCache<Key, Value, CopCompactLfuCache<Key, Value, LockPolicy>>
+	{
+	public:
+		CopHashCompactLfuCache(size_t capacity, int sliceNum, int maxAverageNum = 10)
+			:CopShardedCache<Key, Value, CopCompactLfuCache<Key, Value, LockPolicy>>(capacity, sliceNum, maxAverageNum)
+		{}
+	};
+
+}// coloop
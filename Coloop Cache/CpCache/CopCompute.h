@@ -0,0 +1,63 @@
+#pragma once
+
+namespace CopCache {
+
+	//computeصķֵ:صδü
+	enum class CopComputeAction
+	{
+		Keep,//ԭ״(ֻһη,򲻲)
+		Store,//дص޸ĺֵ
+		Remove//ɾü
+	};
+
+	//ԭӶд:ֻʵ
+	//	template <typename Fn> bool compute(Key key, Fn fn)
+	//ص CopComputeAction fn(Value& value, bool present),һμһβִ,
+	//presentΪfalseʱvalueĬֵ;computeصýüǷ
+	//compute֮ṩõļ,÷getputɵľظ
+	template <typename Derived, typename Key, typename Value>
+	class CopComputeOps
+	{
+	public:
+		//ڼʱִ,صtrueд޸ĺֵ,falseɾü
+		template <typename Fn>
+		bool computeIfPresent(Key key, Fn fn)
+		{
+			return derived().compute(key, [&fn](Value& value, bool present) {
+				if (!present)
+					return CopComputeAction::Keep;
+				return fn(value) ? CopComputeAction::Store : CopComputeAction::Remove;
+			});
+		}
+
+		//ҵǰֵexpectedʱ滻Ϊdesired,Ƿ滻ɹ
+		bool compareAndSet(Key key, const Value& expected, const Value& desired)
+		{
+			bool swapped = false;
+			derived().compute(key, [&](Value& value, bool present) {
+				if (!present || !(value == expected))
+					return CopComputeAction::Keep;
+				value = desired;
+				swapped = true;
+				return CopComputeAction::Store;
+			});
+			return swapped;
+		}
+
+		//ֵ͵,ʱĬֵʼ;ֵ
+		Value increment(Key key, Value delta = Value(1))
+		{
+			Value result{};
+			derived().compute(key, [&](Value& value, bool) {
+				value += delta;
+				result = value;
+				return CopComputeAction::Store;
+			});
+			return result;
+		}
+
+	private:
+		Derived& derived() { return static_cast<Derived&>(*this); }
+	};
+
+}// coloop
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace CopCache {
+
+	//ڵ뿪ԭ
+	enum class CopRemovalCause
+	{
+		Capacity,//㱻̭
+		Explicit,//remove/purgeɾ
+		Expired,//ڻʧЧ
+		Replaced//put˾ֵ
+	};
+
+	//һƳ֪ͨ
+	template <typename Key, typename Value>
+	struct CopRemovalNotice
+	{
+		Key key;
+		Value value;
+		CopRemovalCause cause;
+	};
+
+	//Ƴ,صڻͷ֮
+	//̵ͬ߳οܲͶ,ʵҪб֤̰߳ȫ
+	template <typename Key, typename Value>
+	class CopEvictionListener
+	{
+	public:
+		virtual ~CopEvictionListener() {};
+
+		virtual void onRemoval(const std::vector<CopRemovalNotice<Key, Value>>& notices) = 0;
+	};
+
+	//Ͷݵһ֪ͨ,deliver
+	template <typename Key, typename Value>
+	class CopRemovalBatch
+	{
+	public:
+		using ListenerPtr = std::shared_ptr<CopEvictionListener<Key, Value>>;
+
+		CopRemovalBatch() = default;
+		CopRemovalBatch(ListenerPtr listener, std::vector<CopRemovalNotice<Key, Value>>&& notices)
+			:listener_(std::move(listener))
+			, notices_(std::move(notices))
+		{}
+
+		void deliver()
+		{
+			if (listener_ && !notices_.empty())
+				listener_->onRemoval(notices_);
+			notices_.clear();
+		}
+
+	private:
+		ListenerPtr listener_;
+		std::vector<CopRemovalNotice<Key, Value>> notices_;
+	};
+
+	//Ƴ֪ͨ,ʱ,ǰȡ
+	template <typename Key, typename Value>
+	class CopRemovalQueue
+	{
+	public:
+		using ListenerPtr = std::shared_ptr<CopEvictionListener<Key, Value>>;
+
+		void setListener(ListenerPtr listener) { listener_ = listener; }
+
+		bool enabled() const { return listener_ != nullptr; }
+
+		//ûмʱκο
+		void push(const Key& key, const Value& value, CopRemovalCause cause)
+		{
+			if (listener_)
+				pending_.push_back({ key, value, cause });
+		}
+
+		//ȡǰ֪ܵͨ,ڳʱ
+		CopRemovalBatch<Key, Value> drain()
+		{
+			if (pending_.empty())
+				return CopRemovalBatch<Key, Value>();
+			std::vector<CopRemovalNotice<Key, Value>> notices;
+			notices.swap(pending_);
+			return CopRemovalBatch<Key, Value>(listener_, std::move(notices));
+		}
+
+	private:
+		ListenerPtr listener_;
+		std::vector<CopRemovalNotice<Key, Value>> pending_;
+	};
+
+}// coloop
@@ -0,0 +1,521 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace CopCache {
+
+	//л,Ĭֻֿ֧ƽ,Ҫػ
+	template <typename T, typename Enable = void>
+	struct CopSerializer
+	{
+		static_assert(std::is_trivially_copyable<T>::value,
+			"CopSerializer: ƽҪػCopSerializer");
+
+		static void write(std::string& out, const T& data)
+		{
+			out.append(reinterpret_cast<const char*>(&data), sizeof(T));
+		}
+
+		static bool read(const char* data, size_t len, T& out)
+		{
+			if (len != sizeof(T))
+				return false;
+			std::memcpy(&out, data, sizeof(T));
+			return true;
+		}
+	};
+
+	//ַػ,ɼ¼ͷ,ֱдַ
+	template <>
+	struct CopSerializer<std::string>
+	{
+		static void write(std::string& out, const std::string& data)
+		{
+			out.append(data);
+		}
+
+		static bool read(const char* data, size_t len, std::string& out)
+		{
+			out.assign(data, len);
+			return true;
+		}
+	};
+
+	//־ļ,ֻ׷д;дڻ,С
+	class CopLogFile
+	{
+	public:
+		CopLogFile(size_t batchBytes, size_t blockSize)
+			:blockSize_(blockSize)
+			, buffer_(roundUp(batchBytes, blockSize))
+			, bufferUsed_(0)
+			, fileTail_(0)
+		{}
+
+		bool open(const std::string& path, bool truncate, uint64_t fileTail = 0)
+		{
+			std::ios::openmode mode = std::ios::in | std::ios::out | std::ios::binary;
+			if (truncate)
+				mode |= std::ios::trunc;
+			file_.open(path, mode);
+			bufferUsed_ = 0;
+			fileTail_ = fileTail;
+			return file_.is_open();
+		}
+
+		void close()
+		{
+			flush();
+			file_.close();
+		}
+
+		//׷һ¼,ؼ¼ļе߼ƫ
+		uint64_t append(const char* data, size_t len)
+		{
+			if (bufferUsed_ + len > buffer_.size())
+			{
+				flush();
+				//¼ʱ
+				if (len > buffer_.size())
+					buffer_.resize(roundUp(len, blockSize_));
+			}
+			uint64_t offset = fileTail_ + bufferUsed_;
+			std::memcpy(buffer_.data() + bufferUsed_, data, len);
+			bufferUsed_ += len;
+			return offset;
+		}
+
+		//ѻ뵽߽һд,֤ÿдƫƺͳȶǿ
+		void flush()
+		{
+			if (bufferUsed_ == 0)
+				return;
+			size_t padded = roundUp(bufferUsed_, blockSize_);
+			std::fill(buffer_.begin() + bufferUsed_, buffer_.begin() + padded, 0);
+			file_.seekp(static_cast<std::streamoff>(fileTail_));
+			file_.write(buffer_.data(), static_cast<std::streamsize>(padded));
+			file_.flush();
+			fileTail_ += padded;
+			bufferUsed_ = 0;
+		}
+
+		bool read(uint64_t offset, uint32_t len, std::string& out)
+		{
+			//ڻеļ¼ֱӴڴ濽
+			if (offset >= fileTail_)
+			{
+				size_t pos = static_cast<size_t>(offset - fileTail_);
+				if (pos + len > bufferUsed_)
+					return false;
+				out.assign(buffer_.data() + pos, len);
+				return true;
+			}
+			//ȡü¼
+			uint64_t start = offset / blockSize_ * blockSize_;
+			uint64_t end = roundUp(offset + len, blockSize_);
+			readBuffer_.resize(static_cast<size_t>(end - start));
+			file_.clear();
+			file_.seekg(static_cast<std::streamoff>(start));
+			file_.read(readBuffer_.data(), static_cast<std::streamsize>(readBuffer_.size()));
+			if (!file_)
+			{
+				file_.clear();
+				return false;
+			}
+			out.assign(readBuffer_.data() + (offset - start), len);
+			return true;
+		}
+
+		uint64_t fileTail() const { return fileTail_; }
+		uint64_t tail() const { return fileTail_ + bufferUsed_; }
+
+	private:
+		static uint64_t roundUp(uint64_t n, uint64_t align)
+		{
+			return (n + align - 1) / align * align;
+		}
+
+	private:
+		size_t blockSize_;//С
+		std::vector<char> buffer_;//д
+		size_t bufferUsed_;//ֽ
+		uint64_t fileTail_;//ֵ̲ĩβ()
+		std::vector<char> readBuffer_;
+		std::fstream file_;
+	};
+
+	//:ڴ̭Ľڵд뱾־ļ,ڴֻ
+	//ڴδʱȲһ,кļƳڴ
+	template <typename Key, typename Value>
+	class CopFileTier
+	{
+	public:
+		CopFileTier(const std::string& path,
+			size_t capacityBytes = 64 * 1024 * 1024,
+			size_t batchBytes = 64 * 1024,
+			size_t blockSize = 4096)
+			:path_(path)
+			, capacityBytes_(capacityBytes)
+			, lowWaterBytes_(capacityBytes / 100 * kLowWaterPercent)
+			, batchBytes_(batchBytes)
+			, blockSize_(blockSize)
+			, log_(batchBytes, blockSize)
+			, liveBytes_(0)
+			, garbageBytes_(0)
+			, compactRequested_(false)
+			, stop_(false)
+		{
+			log_.open(path_, true);
+			compactThread_ = std::thread(&CopFileTier::compactionLoop, this);
+		}
+
+		~CopFileTier()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				stop_ = true;
+			}
+			cv_.notify_one();
+			compactThread_.join();
+			log_.close();
+			//ļֻڴ,˳ʱ
+			std::remove(path_.c_str());
+		}
+
+		CopFileTier(const CopFileTier&) = delete;
+		CopFileTier& operator=(const CopFileTier&) = delete;
+
+		//дһ̭ļ¼,Ѵڵľɼ¼Ϊȴѹ
+		void store(const Key& key, const Value& value)
+		{
+			std::string record;
+			encodeRecord(key, value, record);
+
+			std::lock_guard<std::mutex> lock(mutex_);
+			uint64_t offset = log_.append(record.data(), record.size());
+			auto it = index_.find(key);
+			if (it != index_.end())
+			{
+				markGarbage(it->second.length);
+				it->second = { offset, static_cast<uint32_t>(record.size()) };
+			}
+			else
+			{
+				index_.emplace(key, IndexEntry{ offset, static_cast<uint32_t>(record.size()) });
+			}
+			liveBytes_ += record.size();
+			requestCompactionIfNeeded();
+		}
+
+		//Ҳȡ¼,к¼ļƳ,ɵ÷ڴ
+		bool take(const Key& key, Value& value)
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			auto it = index_.find(key);
+			if (it == index_.end())
+				return false;
+
+			std::string record;
+			bool ok = log_.read(it->second.offset, it->second.length, record)
+				&& decodeValue(record, value);
+			markGarbage(it->second.length);
+			index_.erase(it);
+			return ok;
+		}
+
+		//ʽɾ,ֹڴɾִļֵ
+		void erase(const Key& key)
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			auto it = index_.find(key);
+			if (it != index_.end())
+			{
+				markGarbage(it->second.length);
+				index_.erase(it);
+			}
+		}
+
+		bool contains(const Key& key)
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			return index_.find(key) != index_.end();
+		}
+
+		//ȫ¼,ֻ,ļеɺ̨ѹ
+		void clear()
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			garbageBytes_ += liveBytes_;
+			liveBytes_ = 0;
+			index_.clear();
+			requestCompactionIfNeeded();
+		}
+
+		void flush()
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			log_.flush();
+		}
+
+		size_t size()
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			return index_.size();
+		}
+
+	private:
+		static constexpr size_t kLowWaterPercent = 75;//ѹ
+		static constexpr int kCatchUpPasses = 2;//ⲹ׷Ӽ¼
+
+		//:¼ƫ볤
+		struct IndexEntry
+		{
+			uint64_t offset;
+			uint32_t length;
+
+			bool operator==(const IndexEntry& other) const
+			{
+				return offset == other.offset && length == other.length;
+			}
+		};
+
+		//¼ʽ:[][ֵ][][ֵ]
+		static void encodeRecord(const Key& key, const Value& value, std::string& out)
+		{
+			std::string keyBytes;
+			std::string valueBytes;
+			CopSerializer<Key>::write(keyBytes, key);
+			CopSerializer<Value>::write(valueBytes, value);
+			uint32_t keyLen = static_cast<uint32_t>(keyBytes.size());
+			uint32_t valueLen = static_cast<uint32_t>(valueBytes.size());
+			out.reserve(sizeof(keyLen) + sizeof(valueLen) + keyLen + valueLen);
+			out.append(reinterpret_cast<const char*>(&keyLen), sizeof(keyLen));
+			out.append(reinterpret_cast<const char*>(&valueLen), sizeof(valueLen));
+			out.append(keyBytes);
+			out.append(valueBytes);
+		}
+
+		static bool decodeValue(const std::string& record, Value& value)
+		{
+			uint32_t keyLen = 0;
+			uint32_t valueLen = 0;
+			if (record.size() < sizeof(keyLen) + sizeof(valueLen))
+				return false;
+			std::memcpy(&keyLen, record.data(), sizeof(keyLen));
+			std::memcpy(&valueLen, record.data() + sizeof(keyLen), sizeof(valueLen));
+			size_t header = sizeof(keyLen) + sizeof(valueLen);
+			if (header + keyLen + valueLen != record.size())
+				return false;
+			return CopSerializer<Value>::read(record.data() + header + keyLen, valueLen, value);
+		}
+
+		void markGarbage(uint32_t length)
+		{
+			liveBytes_ -= length;
+			garbageBytes_ += length;
+		}
+
+		//Ч,Чݳʱ,Ѻ̨߳ѹ
+		void requestCompactionIfNeeded()
+		{
+			bool tooMuchGarbage = garbageBytes_ > liveBytes_ && garbageBytes_ > 4 * batchBytes_;
+			if ((tooMuchGarbage || liveBytes_ > capacityBytes_) && !compactRequested_)
+			{
+				compactRequested_ = true;
+				cv_.notify_one();
+			}
+		}
+
+		void compactionLoop()
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			while (true)
+			{
+				cv_.wait(lock, [this] { return stop_ || compactRequested_; });
+				if (stop_)
+					return;
+				compact(lock);
+				compactRequested_ = false;
+			}
+		}
+
+		//һļļ¼:ļеλáļеλ
+		struct Move
+		{
+			Key key;
+			IndexEntry from;
+			IndexEntry to;
+		};
+
+		//ⰴ˳򿽱һ¼ļ,࿽budgetֽ,ʵʿֽ
+		size_t copyRecords(const std::vector<std::pair<Key, IndexEntry>>& entries, uint64_t tail,
+			size_t budget, CopLogFile& writer, std::vector<Move>& moves)
+		{
+			CopLogFile reader(blockSize_, blockSize_);
+			reader.open(path_, false, tail);
+			size_t copied = 0;
+			std::string record;
+			for (const auto& pair : entries)
+			{
+				const IndexEntry& entry = pair.second;
+				if (copied + entry.length > budget)
+					break;
+				if (!reader.read(entry.offset, entry.length, record))
+					continue;
+				uint64_t offset = writer.append(record.data(), record.size());
+				moves.push_back(Move{ pair.first, entry, IndexEntry{ offset, entry.length } });
+				copied += entry.length;
+			}
+			reader.close();
+			return copied;
+		}
+
+		//ѹ:µɿЧ¼ļ,ֻˮλ,ɵļ¼
+		//֮Ҫд(100-kLowWaterPercent)%Ż򳬳ٴѹ,ʱÿд붼дļ
+		//ֽ:һֿ,֮ÿֲһڼ׷ӵļ¼,βʱֻʣһڼ׷
+		void compact(std::unique_lock<std::mutex>& lock)
+		{
+			std::string compactPath = path_ + ".compact";
+			CopLogFile writer(batchBytes_, blockSize_);
+			writer.open(compactPath, true);
+
+			std::vector<std::vector<Move>> passes;//ÿֵĿ,ִԽ¼Խ
+			std::vector<std::pair<Key, IndexEntry>> skipped;//һֳˮλûпɼ¼
+			size_t writtenBytes = 0;
+			uint64_t passStart = 0;
+			for (int pass = 0; ; ++pass)
+			{
+				log_.flush();
+				uint64_t passTail = log_.fileTail();
+				std::vector<std::pair<Key, IndexEntry>> entries;
+				for (const auto& pair : index_)
+				{
+					if (pair.second.offset >= passStart)
+						entries.push_back(pair);
+				}
+				lock.unlock();
+
+				//ַΧڵֻᱻ׷Ӳᱻд,öľȡ
+				std::sort(entries.begin(), entries.end(),
+					[](const std::pair<Key, IndexEntry>& a, const std::pair<Key, IndexEntry>& b) {
+						return a.second.offset > b.second.offset;
+					});
+				passes.emplace_back();
+				size_t budget = pass == 0 ? lowWaterBytes_ : SIZE_MAX;
+				writtenBytes += copyRecords(entries, passTail, budget, writer, passes.back());
+				if (pass == 0)
+					skipped.assign(entries.begin() + passes.back().size(), entries.end());
+
+				lock.lock();
+				passStart = passTail;
+				//׷ӵĲһ,򲹿,β
+				if (pass >= kCatchUpPasses || log_.tail() - passTail <= batchBytes_)
+					break;
+			}
+			log_.flush();
+
+			//ȼһ֮׷ӵļ¼;Ҫǰֱȶٰ,λÿλͬ
+			std::vector<IndexEntry*> fresh;
+			size_t liveBytes = 0;
+			for (auto& pair : index_)
+			{
+				if (pair.second.offset >= passStart)
+				{
+					fresh.push_back(&pair.second);
+					liveBytes += pair.second.length;
+				}
+			}
+
+			//ѹڼûȡ߻򸲸ǵļ¼Ч;Чݳˮλʱɵһĩβʼ
+			std::vector<std::vector<bool>> valid(passes.size());
+			for (size_t p = 0; p < passes.size(); ++p)
+			{
+				for (const Move& move : passes[p])
+				{
+					auto it = index_.find(move.key);
+					bool ok = it != index_.end() && it->second == move.from;
+					valid[p].push_back(ok);
+					if (ok)
+						liveBytes += move.from.length;
+				}
+			}
+			for (size_t p = 0; p < passes.size() && liveBytes > lowWaterBytes_; ++p)
+			{
+				for (size_t i = passes[p].size(); i-- > 0 && liveBytes > lowWaterBytes_; )
+				{
+					if (!valid[p][i])
+						continue;
+					valid[p][i] = false;
+					liveBytes -= passes[p][i].from.length;
+					index_.erase(passes[p][i].key);
+				}
+			}
+			for (size_t p = 0; p < passes.size(); ++p)
+			{
+				for (size_t i = 0; i < passes[p].size(); ++i)
+				{
+					if (valid[p][i])
+						index_[passes[p][i].key] = passes[p][i].to;
+				}
+			}
+			for (const auto& pair : skipped)
+			{
+				auto it = index_.find(pair.first);
+				if (it != index_.end() && it->second == pair.second)
+					index_.erase(it);
+			}
+			//һ֮ļ¼ڲ;ֻɾ˸Ŀ,ЩָȻЧ
+			std::string record;
+			for (IndexEntry* entry : fresh)
+			{
+				if (log_.read(entry->offset, entry->length, record))
+				{
+					entry->offset = writer.append(record.data(), record.size());
+					writtenBytes += entry->length;
+				}
+			}
+
+			writer.close();
+			log_.close();
+			std::remove(path_.c_str());
+			std::rename(compactPath.c_str(), path_.c_str());
+			log_.open(path_, false, writer.fileTail());
+
+			liveBytes_ = 0;
+			for (auto& pair : index_)
+				liveBytes_ += pair.second.length;
+			//ļ�ʧЧ򱻶ļ¼
+			garbageBytes_ = writtenBytes - liveBytes_;
+		}
+
+	private:
+		std::string path_;
+		size_t capacityBytes_;//ļЧ
+		size_t lowWaterBytes_;//ѹЧ
+		size_t batchBytes_;//дС
+		size_t blockSize_;//С
+		CopLogFile log_;
+		std::unordered_map<Key, IndexEntry> index_;// -> ļλõĽ
+		size_t liveBytes_;//Ч¼ֽ
+		size_t garbageBytes_;//ʧЧ¼ֽ
+
+		std::mutex mutex_;
+		std::condition_variable cv_;
+		bool compactRequested_;
+		bool stop_;
+		std::thread compactThread_;//̨ѹ߳
+	};
+
+}// coloop
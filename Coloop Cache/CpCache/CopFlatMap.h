@@ -0,0 +1,234 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace CopCache {
+
+	//ϣ:ֽڿ64λٻ,ûз֧
+	//seedòͬ;(Ƭ/ڶλ)õصĹϣֵ
+	template <typename Key>
+	inline uint64_t copIntHash(const Key& key, uint64_t seed = 0)
+	{
+		static_assert(sizeof(Key) <= 16, "copIntHash only supports keys up to 16 bytes");
+		uint64_t words[2] = { 0, 0 };
+		std::memcpy(words, &key, sizeof(Key));
+		uint64_t h = (words[0] ^ seed) * 0x9E3779B97F4A7C15ULL;
+		h ^= (words[1] + (h >> 29)) * 0xC2B2AE3D27D4EB4FULL;
+		h ^= h >> 32;
+		h *= 0xD6E8FEB86659FD93ULL;
+		h ^= h >> 32;
+		return h;
+	}
+
+	//ƽѰַϣ,רƽļʹ
+	//ֱֵӴ,һֽ鱣λ(0Ϊ,Ϊ0x80|7λϣǩ)
+	//̽ʱɨյĿֽ,ǩͬűȽϼ;ɾʹû,Ĺ
+	//ӿֻǻõĲ:find/erase/operator[]/,eraseʹʧЧ
+	template <typename Key, typename Mapped>
+	class CopFlatMap
+	{
+	public:
+		using value_type = std::pair<Key, Mapped>;
+
+		template <bool IsConst>
+		class Iterator
+		{
+		public:
+			using MapPtr = typename std::conditional<IsConst, const CopFlatMap*, CopFlatMap*>::type;
+			using Reference = typename std::conditional<IsConst, const value_type&, value_type&>::type;
+			using Pointer = typename std::conditional<IsConst, const value_type*, value_type*>::type;
+
+			Iterator(MapPtr map, size_t pos) :map_(map), pos_(pos) { skipEmpty(); }
+
+			Reference operator*() const { return map_->slots_[pos_]; }
+			Pointer operator->() const { return &map_->slots_[pos_]; }
+
+			Iterator& operator++()
+			{
+				++pos_;
+				skipEmpty();
+				return *this;
+			}
+
+			bool operator==(const Iterator& other) const { return pos_ == other.pos_; }
+			bool operator!=(const Iterator& other) const { return pos_ != other.pos_; }
+
+		private:
+			friend class CopFlatMap;
+
+			void skipEmpty()
+			{
+				while (pos_ < map_->ctrl_.size() && map_->ctrl_[pos_] == 0)
+					++pos_;
+			}
+
+			MapPtr map_;
+			size_t pos_;
+		};
+
+		using iterator = Iterator<false>;
+		using const_iterator = Iterator<true>;
+
+		CopFlatMap() :size_(0)
+		{
+			resize(16);
+		}
+
+		iterator begin() { return iterator(this, 0); }
+		iterator end() { return iterator(this, ctrl_.size()); }
+		const_iterator begin() const { return const_iterator(this, 0); }
+		const_iterator end() const { return const_iterator(this, ctrl_.size()); }
+
+		iterator find(const Key& key)
+		{
+			size_t pos;
+			return findSlot(key, hashOf(key), pos) ? iterator(this, pos) : end();
+		}
+
+		const_iterator find(const Key& key) const
+		{
+			size_t pos;
+			return findSlot(key, hashOf(key), pos) ? const_iterator(this, pos) : end();
+		}
+
+		size_t count(const Key& key) const
+		{
+			size_t pos;
+			return findSlot(key, hashOf(key), pos) ? 1 : 0;
+		}
+
+		//ʱĬֵ
+		Mapped& operator[](const Key& key)
+		{
+			uint64_t h = hashOf(key);
+			size_t pos;
+			if (findSlot(key, h, pos))
+				return slots_[pos].second;
+			//̽,װӳ3/4ʱ
+			if ((size_ + 1) * 4 > ctrl_.size() * 3)
+			{
+				resize(ctrl_.size() * 2);
+				findSlot(key, h, pos);
+			}
+			ctrl_[pos] = tagOf(h);
+			slots_[pos].first = key;
+			++size_;
+			return slots_[pos].second;
+		}
+
+		void erase(iterator it)
+		{
+			eraseSlot(it.pos_);
+		}
+
+		size_t erase(const Key& key)
+		{
+			size_t pos;
+			if (!findSlot(key, hashOf(key), pos))
+				return 0;
+			eraseSlot(pos);
+			return 1;
+		}
+
+		//ƽ,ֻÿֽڲͷӳֵ
+		void clear()
+		{
+			for (size_t i = 0; i < ctrl_.size(); ++i)
+			{
+				if (ctrl_[i] != 0)
+					slots_[i].second = Mapped();
+			}
+			std::fill(ctrl_.begin(), ctrl_.end(), 0);
+			size_ = 0;
+		}
+
+		void reserve(size_t count)
+		{
+			size_t tableSize = ctrl_.size();
+			while (count * 4 > tableSize * 3)
+				tableSize <<= 1;
+			if (tableSize != ctrl_.size())
+				resize(tableSize);
+		}
+
+		size_t size() const { return size_; }
+		bool empty() const { return size_ == 0; }
+
+	private:
+		static uint64_t hashOf(const Key& key) { return copIntHash(key); }
+		//ǩȡ7λ,λõλ,߻ص
+		static uint8_t tagOf(uint64_t h) { return static_cast<uint8_t>(0x80 | (h >> 57)); }
+
+		static bool sameKey(const Key& a, const Key& b)
+		{
+			return std::memcmp(&a, &b, sizeof(Key)) == 0;
+		}
+
+		//̽,ҵtrue;ҲʱposΪɲĿղ
+		bool findSlot(const Key& key, uint64_t h, size_t& pos) const
+		{
+			size_t mask = ctrl_.size() - 1;
+			uint8_t tag = tagOf(h);
+			pos = static_cast<size_t>(h) & mask;
+			while (ctrl_[pos] != 0)
+			{
+				if (ctrl_[pos] == tag && sameKey(slots_[pos].first, key))
+					return true;
+				pos = (pos + 1) & mask;
+			}
+			return false;
+		}
+
+		//ɾ,֤̽Ͽ
+		void eraseSlot(size_t pos)
+		{
+			size_t mask = ctrl_.size() - 1;
+			size_t next = (pos + 1) & mask;
+			while (ctrl_[next] != 0)
+			{
+				size_t home = static_cast<size_t>(hashOf(slots_[next].first)) & mask;
+				//nextλò(pos, next]ʱǰ
+				if (((next - home) & mask) >= ((next - pos) & mask))
+				{
+					ctrl_[pos] = ctrl_[next];
+					slots_[pos] = std::move(slots_[next]);
+					pos = next;
+				}
+				next = (next + 1) & mask;
+			}
+			ctrl_[pos] = 0;
+			slots_[pos].second = Mapped();
+			--size_;
+		}
+
+		void resize(size_t tableSize)
+		{
+			std::vector<uint8_t> oldCtrl(tableSize, 0);
+			std::vector<value_type> oldSlots(tableSize);
+			oldCtrl.swap(ctrl_);
+			oldSlots.swap(slots_);
+			size_t mask = tableSize - 1;
+			for (size_t i = 0; i < oldCtrl.size(); ++i)
+			{
+				if (oldCtrl[i] == 0)
+					continue;
+				size_t pos = static_cast<size_t>(hashOf(oldSlots[i].first)) & mask;
+				while (ctrl_[pos] != 0)
+					pos = (pos + 1) & mask;
+				ctrl_[pos] = oldCtrl[i];
+				slots_[pos] = std::move(oldSlots[i]);
+			}
+		}
+
+	private:
+		std::vector<uint8_t> ctrl_;//ֽ,һи64λ
+		std::vector<value_type> slots_;//ŵļֵ
+		size_t size_;
+	};
+
+}// coloop
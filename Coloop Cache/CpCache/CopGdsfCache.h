@@ -0,0 +1,297 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <utility>
+
+#include "CopCachePolicy.h"
+#include "CopEvictionListener.h"
+#include "CopKeyTraits.h"
+#include "CopLockPolicy.h"
+#include "CopLockProfiler.h"
+#include "CopShardedCache.h"
+
+namespace CopCache {
+
+	//GreedyDual-Size-Frequency:"ؽ/ռôС"ȨķƵ̭
+	//ȼ H = L + Ƶ *  / С,ÿ̭ȼ͵Ŀ,ֵĻߵ̭ߵH,
+	//·ʵĿڳδʵľĿ֮ǰ,ϻ
+	//С(λɵ÷,ֽ);ۺʹСputĿʱۺʹС,¼1С1
+	//ȼṹΪ,롢ʺ̭O(log n)
+	template <typename Key, typename Value, typename LockPolicy = CopMutexLock>
+	class CopGdsfCache : public CopCachePolicy<Key, Value>
+	{
+	public:
+		using ListenerPtr = std::shared_ptr<CopEvictionListener<Key, Value>>;
+
+		explicit CopGdsfCache(size_t capacity)
+			:capacity_(capacity)
+			, used_(0)
+			, inflation_(0.0)
+			, seq_(0)
+		{}
+
+		~CopGdsfCache() override = default;
+
+		//ͨðװ(Ƭ桢CopTracedCacheCopHotKeyCache)ֻ汾,ʱܰѴĿļǳ1λ
+		void put(Key key, Value value) override
+		{
+			putInternal(key, value, 1.0, 1, true);
+		}
+
+		//costΪؽĿĴ(),sizeΪռôС;СĿ
+		void put(Key key, Value value, double cost, size_t size)
+		{
+			putInternal(key, value, cost, size, false);
+		}
+
+		bool get(Key key, Value& value) override
+		{
+			CopLockOpScope opScope(CopLockOp::Get);
+			std::lock_guard<LockPolicy> lock(mutex_);
+			auto it = entryMap_.find(key);
+			if (it == entryMap_.end())
+				return false;
+			touch(key, it->second);
+			value = it->second.value;
+			return true;
+		}
+
+		Value get(Key key) override
+		{
+			Value value{};
+			get(key, value);
+			return value;
+		}
+
+		void remove(Key key)
+		{
+			CopRemovalBatch<Key, Value> removed;
+			{
+				std::lock_guard<LockPolicy> lock(mutex_);
+				auto it = entryMap_.find(key);
+				if (it != entryMap_.end())
+				{
+					removals_.push(key, it->second.value, CopRemovalCause::Explicit);
+					queue_.erase(it->second.slot);
+					used_ -= it->second.size;
+					entryMap_.erase(it);
+				}
+				removed = removals_.drain();
+			}
+			removed.deliver();
+		}
+
+		//ֻ:Ƶ
+		bool contains(Key key)
+		{
+			std::shared_lock<LockPolicy> lock(mutex_);
+			return entryMap_.find(key) != entryMap_.end();
+		}
+
+		//ߵ,ַ̭
+		void setCapacity(size_t capacity)
+		{
+			{
+				std::lock_guard<LockPolicy> lock(mutex_);
+				capacity_ = capacity;
+			}
+			bool done = false;
+			while (!done)
+			{
+				CopRemovalBatch<Key, Value> removed;
+				{
+					std::lock_guard<LockPolicy> lock(mutex_);
+					for (size_t i = 0; i < CopResizeStep && used_ > capacity_; ++i)
+						evictOne(nullptr);
+					done = used_ <= capacity_;
+					removed = removals_.drain();
+				}
+				removed.deliver();
+			}
+		}
+
+		size_t capacity()
+		{
+			std::shared_lock<LockPolicy> lock(mutex_);
+			return capacity_;
+		}
+
+		size_t size()
+		{
+			std::shared_lock<LockPolicy> lock(mutex_);
+			return entryMap_.size();
+		}
+
+		//ǰռõĴС
+		size_t usedSize()
+		{
+			std::shared_lock<LockPolicy> lock(mutex_);
+			return used_;
+		}
+
+		//ǰֵ,һα̭Ŀȼ
+		double inflation()
+		{
+			std::shared_lock<LockPolicy> lock(mutex_);
+			return inflation_;
+		}
+
+		CopLockStats lockStats() const
+		{
+			return copLockStats(mutex_);
+		}
+
+		void setRemovalListener(ListenerPtr listener)
+		{
+			std::lock_guard<LockPolicy> lock(mutex_);
+			removals_.setListener(listener);
+		}
+
+	private:
+		//ȼͬʱ̭ȼĿ
+		using Priority = std::pair<double, uint64_t>;
+		using Queue = std::map<Priority, Key>;
+
+		struct Entry
+		{
+			Value value{};
+			double cost = 1.0;//ؽ
+			size_t size = 1;//ռôС
+			uint64_t freq = 0;//Ƶ
+			typename Queue::iterator slot;//ȼеλ
+		};
+
+		using EntryMap = typename CopKeyTraits<Key>::template MapType<Entry>;
+
+		//keepShapeΪtrueʱ,ĿԭĴۺʹС
+		void putInternal(const Key& key, const Value& value, double cost, size_t size, bool keepShape)
+		{
+			CopLockOpScope opScope(CopLockOp::Put);
+			CopRemovalBatch<Key, Value> removed;
+			{
+				std::lock_guard<LockPolicy> lock(mutex_);
+				auto it = entryMap_.find(key);
+				if (keepShape && it != entryMap_.end())
+				{
+					cost = it->second.cost;
+					size = it->second.size;
+				}
+				size = std::max<size_t>(1, size);
+				if (it != entryMap_.end() && size > capacity_)
+				{
+					//ֵŲ,ֵҲٱ
+					removals_.push(key, it->second.value, CopRemovalCause::Replaced);
+					queue_.erase(it->second.slot);
+					used_ -= it->second.size;
+					entryMap_.erase(it);
+				}
+				else if (it != entryMap_.end())
+				{
+					Entry& entry = it->second;
+					removals_.push(key, entry.value, CopRemovalCause::Replaced);
+					entry.value = value;
+					used_ -= entry.size;
+					entry.cost = cost;
+					entry.size = size;
+					used_ += size;
+					touch(key, entry);
+				}
+				else if (size <= capacity_)
+				{
+					Entry entry;
+					entry.value = value;
+					entry.cost = cost;
+					entry.size = size;
+					entry.freq = 0;
+					used_ += size;
+					touch(key, entry);
+					entryMap_[key] = entry;
+				}
+				//ǺĿҲܳ,̭ʱдļ
+				while (used_ > capacity_ && evictOne(&key))
+				{
+				}
+				removed = removals_.drain();
+			}
+			removed.deliver();
+		}
+
+		//һ:ƵμһµȼŶ
+		void touch(const Key& key, Entry& entry)
+		{
+			if (entry.freq > 0)
+				queue_.erase(entry.slot);
+			++entry.freq;
+			double priority = inflation_ + static_cast<double>(entry.freq) * entry.cost / static_cast<double>(entry.size);
+			entry.slot = queue_.emplace(Priority(priority, ++seq_), key).first;
+		}
+
+		//̭ȼ͵Ŀ,skipΪҪļ;ûп̭Ŀʱfalse
+		bool evictOne(const Key* skip)
+		{
+			auto victim = queue_.begin();
+			if (victim != queue_.end() && skip && victim->second == *skip)
+				++victim;
+			if (victim == queue_.end())
+				return false;
+			copLockNote(CopLockOp::Evict);
+			auto it = entryMap_.find(victim->second);
+			inflation_ = victim->first.first;
+			removals_.push(it->first, it->second.value, CopRemovalCause::Capacity);
+			used_ -= it->second.size;
+			queue_.erase(victim);
+			entryMap_.erase(it);
+			return true;
+		}
+
+	private:
+		size_t capacity_;//(С֮)
+		size_t used_;//ռôС
+		double inflation_;//ֵL
+		uint64_t seq_;//ͬȼʱȺ˳
+		LockPolicy mutex_;
+		Queue queue_;//ȼӵ͵
+		EntryMap entryMap_;
+		CopRemovalQueue<Key, Value> removals_;
+	};
+
+	//GDSFķƬ汾,ÿƬΪƬ
+	template <typename Key, typename Value, typename LockPolicy = CopMutexLock>
+	class CopHashGdsfCache : public CopShardedCache<Key, Value, CopGdsfCache<Key, Value, LockPolicy>>
+	{
+		using Base = CopShardedCache<Key, Value, CopGdsfCache<Key, Value, LockPolicy>>;
+
+	public:
+		CopHashGdsfCache(size_t capacity, int sliceNum)
+			:Base(capacity, sliceNum)
+		{}
+
+		using Base::put;
+
+		void put(Key key, Value value, double cost, size_t size)
+		{
+			size_t index = this->sliceIndex(key);
+			this->slices_[index]->put(key, value, cost, size);
+			this->bumpVersion(index);
+			if (this->negative_)
+				this->negative_->erase(key);
+			if (this->trace_)
+				this->trace_->record(key, CopTraceOp::Put, false, size);
+		}
+
+		//ƬôС֮
+		size_t usedSize()
+		{
+			size_t used = 0;
+			for (int i = 0; i < this->sliceNum_; ++i)
+				used += this->slices_[i]->usedSize();
+			return used;
+		}
+	};
+
+}// coloop
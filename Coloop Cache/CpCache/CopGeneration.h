@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+
+namespace CopCache {
+
+	//ݱǩ(⻧/ռ),0ʾǩ
+	using CopTag = uint32_t;
+
+	//ʧЧ:ÿʧЧʱӼһ¸ʱ,дʱ¼ʱʱ
+	//дʱȫʧЧʱ̻ǩʧЧʱ̼Ϊ,ʧЧO(1),
+	//ɻڷʡ̭ɨʱա,
+	class CopGenerations
+	{
+	public:
+		CopGenerations()
+			:clock_(1)
+			, allBefore_(0)
+		{}
+
+		//дݵʱ
+		uint64_t stamp() const { return clock_; }
+
+		void invalidateAll()
+		{
+			allBefore_ = ++clock_;
+		}
+
+		void invalidateTag(CopTag tag)
+		{
+			if (tag != 0)
+				tagBefore_[tag] = ++clock_;
+		}
+
+		//ǷʧЧ,ûʱɨֱ
+		bool hasInvalidations() const { return clock_ > 1; }
+
+		bool isStale(uint64_t stamp, CopTag tag) const
+		{
+			if (stamp < allBefore_)
+				return true;
+			if (tag == 0 || tagBefore_.empty())
+				return false;
+			auto it = tagBefore_.find(tag);
+			return it != tagBefore_.end() && stamp < it->second;
+		}
+
+	private:
+		uint64_t clock_;//ʧЧʱ
+		uint64_t allBefore_;//ڸʱдȫ
+		std::unordered_map<CopTag, uint64_t> tagBefore_;//ǩʧЧʱ
+	};
+
+}// coloop
@@ -0,0 +1,309 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "CopCachePolicy.h"
+#include "CopCompute.h"
+#include "CopKeyTraits.h"
+
+namespace CopCache {
+
+	//ȵ̽:Էʰ,Space-Saving㷨ڹ̶ļƷļ
+	//ʱ滻Сļ̳ļ,ֵֻƫ;ÿ,ȵ𽥵
+	//,ɵ÷
+	template <typename Key>
+	class CopHotKeyDetector
+	{
+	public:
+		explicit CopHotKeyDetector(size_t counters = 64)
+			:counters_(counters)
+			, samples_(0)
+		{}
+
+		void record(const Key& key)
+		{
+			++samples_;
+			auto it = counts_.find(key);
+			if (it != counts_.end())
+			{
+				++it->second;
+				return;
+			}
+			if (counts_.size() < counters_)
+			{
+				counts_.emplace(key, 1);
+				return;
+			}
+			auto minIt = counts_.begin();
+			for (auto cur = counts_.begin(); cur != counts_.end(); ++cur)
+			{
+				if (cur->second < minIt->second)
+					minIt = cur;
+			}
+			uint64_t inherited = minIt->second;
+			counts_.erase(minIt);
+			counts_.emplace(key, inherited + 1);
+		}
+
+		size_t samples() const { return samples_; }
+
+		//ռȲshareļ,ӴС෵limit,Ȼ˥
+		std::vector<Key> takeHot(double share, size_t limit)
+		{
+			std::vector<std::pair<uint64_t, Key>> ranked;
+			uint64_t threshold = static_cast<uint64_t>(samples_ * share) + 1;
+			for (const auto& pair : counts_)
+			{
+				if (pair.second >= threshold)
+					ranked.emplace_back(pair.second, pair.first);
+			}
+			std::sort(ranked.begin(), ranked.end(),
+				[](const std::pair<uint64_t, Key>& a, const std::pair<uint64_t, Key>& b) { return a.first > b.first; });
+
+			std::vector<Key> hot;
+			for (size_t i = 0; i < ranked.size() && i < limit; ++i)
+				hot.push_back(ranked[i].second);
+
+			for (auto it = counts_.begin(); it != counts_.end();)
+			{
+				it->second /= 2;
+				if (it->second == 0)
+					it = counts_.erase(it);
+				else
+					++it;
+			}
+			samples_ /= 2;
+			return hot;
+		}
+
+	private:
+		size_t counters_;//
+		uint64_t samples_;//
+		std::unordered_map<Key, uint64_t> counts_;
+	};
+
+	//ȵ:ڷƬ(CopShardedCache)ǰ
+	//̽⵽ȵƵƬʼreplicasڷƬ,̷߳ɢЩ,
+	//һǼ̶߳ѹͬһƬ
+	//ȵ㼯һźСָƱ,ȵĶֻһֻɨ
+	//ȵputָдƬи,֤һ;̭ʱƬ,
+	//ʱƬɾ;ƬҪ֧compute(LRU/LFU/SLRU)
+	template <typename Key, typename Value, typename Sharded>
+	class CopHotKeyCache : public CopCachePolicy<Key, Value>
+	{
+	public:
+		//replicasΪÿȵĸ(Ƭ),sampleRateʾÿٴζһ,
+		//hotShareΪжȵͷռ
+		CopHotKeyCache(Sharded& backend, int replicas = 4, uint32_t sampleRate = 64,
+			double hotShare = 0.01, size_t counters = 64)
+			:backend_(backend)
+			, replicas_(std::max(1, std::min(replicas, backend.sliceNum())))
+			, sampleRate_(std::max<uint32_t>(1, sampleRate))
+			, hotShare_(hotShare)
+			, hotCount_(0)
+			, detector_(counters)
+		{
+			for (auto& slot : hotSet_)
+				slot.store(0, std::memory_order_relaxed);
+		}
+
+		~CopHotKeyCache() override = default;
+
+		void put(Key key, Value value) override
+		{
+			uint64_t fp = fingerprint(key);
+			if (!isHot(fp, true))
+			{
+				backend_.put(key, value);
+				//дƬټȵ:ʱԲ,֮һܴƬд
+				if (!isHot(fp, true))
+					return;
+			}
+			//Ƭ͸ͬһд,put˳Ч,ֵ߲ͬ
+			std::lock_guard<std::mutex> lock(replicaMutex_);
+			backend_.put(key, value);
+			//ڼѱ,ʱɾ,д
+			if (!isHot(fp, true))
+				return;
+			size_t home = backend_.sliceIndexOf(key);
+			for (int i = 1; i < replicas_; ++i)
+				backend_.slice(replicaSlice(home, i)).put(key, value);
+		}
+
+		bool get(Key key, Value& value) override
+		{
+			sample(key);
+			if (replicas_ > 1 && isHot(fingerprint(key), false))
+			{
+				size_t home = backend_.sliceIndexOf(key);
+				int replica = static_cast<int>(threadSlot() % replicas_);
+				if (replica != 0)
+				{
+					if (backend_.slice(replicaSlice(home, replica)).get(key, value))
+						return true;
+					return refill(key, home, replica, value);
+				}
+			}
+			return backend_.get(key, value);
+		}
+
+		Value get(Key key) override
+		{
+			Value value{};
+			get(key, value);
+			return value;
+		}
+
+		//ǰȵ
+		size_t hotKeys() const { return hotCount_.load(std::memory_order_relaxed); }
+
+		Sharded& backend() { return backend_; }
+
+	private:
+		static constexpr size_t kMaxHot = 16;//ͬʱƵȵ
+		static constexpr size_t kEvaluateEvery = 1024;//ÿôһ
+
+		//ָλΪ1ʾѾ;ڼλȴλΪ0""ֵ,
+		//ʱдѾҪͬ,Ƭ,һľɸ
+		static uint64_t fingerprint(const Key& key)
+		{
+			return static_cast<uint64_t>(CopKeyTraits<Key>::hash(key)) | 3;
+		}
+
+		static uint64_t pending(uint64_t fp) { return fp & ~static_cast<uint64_t>(1); }
+
+		bool isHot(uint64_t fp, bool includePending) const
+		{
+			if (hotCount_.load(std::memory_order_seq_cst) == 0)
+				return false;
+			for (const auto& slot : hotSet_)
+			{
+				uint64_t cur = slot.load(std::memory_order_seq_cst);
+				if (cur == fp || (includePending && cur == pending(fp)))
+					return true;
+			}
+			return false;
+		}
+
+		size_t replicaSlice(size_t home, int replica) const
+		{
+			return (home + replica) % backend_.sliceNum();
+		}
+
+		//ÿ̶̹߳ͬһ,֮߳Ȼɢ
+		static size_t threadSlot()
+		{
+			static std::atomic<size_t> nextSlot(0);
+			thread_local size_t slot = nextSlot.fetch_add(1, std::memory_order_relaxed);
+			return slot;
+		}
+
+		//ȱʧ:Ƭдظ,ָ⸲ǲputֵ
+		//ڼѽʱֻƬ,ؽ
+		bool refill(const Key& key, size_t home, int replica, Value& value)
+		{
+			std::lock_guard<std::mutex> lock(replicaMutex_);
+			if (!backend_.get(key, value))
+				return false;
+			if (isHot(fingerprint(key), false))
+				backend_.slice(replicaSlice(home, replica)).put(key, value);
+			return true;
+		}
+
+		//ƬķƬɾ,ͷռõ
+		void dropReplicas(const Key& key)
+		{
+			size_t home = backend_.sliceIndexOf(key);
+			for (int r = 1; r < replicas_; ++r)
+			{
+				backend_.slice(replicaSlice(home, r)).compute(key, [](Value&, bool present) {
+					return present ? CopComputeAction::Remove : CopComputeAction::Keep;
+				});
+			}
+		}
+
+		void sample(const Key& key)
+		{
+			thread_local uint32_t tick = 0;
+			if (++tick % sampleRate_ != 0)
+				return;
+
+			std::vector<Key> hot;
+			{
+				std::lock_guard<std::mutex> lock(detectorMutex_);
+				detector_.record(key);
+				if (detector_.samples() < kEvaluateEvery)
+					return;
+				hot = detector_.takeHot(hotShare_, kMaxHot);
+			}
+			updateHotSet(hot);
+		}
+
+		//滻ȵ㼯:Ƚȵļɾ丱,ȵ㲢Ƶ
+		void updateHotSet(const std::vector<Key>& hot)
+		{
+			std::lock_guard<std::mutex> lock(replicaMutex_);
+			std::vector<uint64_t> fps;
+			for (const Key& key : hot)
+				fps.push_back(fingerprint(key));
+
+			for (size_t s = 0; s < kMaxHot; ++s)
+			{
+				uint64_t fp = hotSet_[s].load(std::memory_order_relaxed);
+				if (fp != 0 && std::find(fps.begin(), fps.end(), fp) == fps.end())
+				{
+					//ָöصƬ,ɾ
+					hotSet_[s].store(0, std::memory_order_seq_cst);
+					hotCount_.fetch_sub(1, std::memory_order_seq_cst);
+					dropReplicas(hotKeys_[s]);
+				}
+			}
+
+			for (size_t i = 0; i < hot.size(); ++i)
+			{
+				if (isHot(fps[i], false))
+					continue;
+				auto empty = std::find_if(hotSet_, hotSet_ + kMaxHot,
+					[](const std::atomic<uint64_t>& slot) { return slot.load(std::memory_order_relaxed) == 0; });
+				if (empty == hotSet_ + kMaxHot)
+					break;
+				//ȱǴٶƬ:֮ɵputῴǲڱͷźͬ
+				hotKeys_[empty - hotSet_] = hot[i];
+				hotCount_.fetch_add(1, std::memory_order_seq_cst);
+				empty->store(pending(fps[i]), std::memory_order_seq_cst);
+				Value value{};
+				if (!backend_.get(hot[i], value))
+				{
+					empty->store(0, std::memory_order_seq_cst);
+					hotCount_.fetch_sub(1, std::memory_order_seq_cst);
+					continue;
+				}
+				size_t home = backend_.sliceIndexOf(hot[i]);
+				for (int r = 1; r < replicas_; ++r)
+					backend_.slice(replicaSlice(home, r)).put(hot[i], value);
+				//дŶԶ
+				empty->store(fps[i], std::memory_order_seq_cst);
+			}
+		}
+
+	private:
+		Sharded& backend_;//ķƬ
+		int replicas_;//ÿȵĸ
+		uint32_t sampleRate_;//
+		double hotShare_;//ȵжռ
+
+		std::atomic<uint64_t> hotSet_[kMaxHot];//ȵָ,0Ϊ
+		Key hotKeys_[kMaxHot];//hotSet_Ӧļ,ʱɾ,replicaMutex_
+		std::atomic<size_t> hotCount_;//ȵ,Ϊ0ʱ·ֱɨ
+		std::mutex replicaMutex_;//лȵ븱
+
+		std::mutex detectorMutex_;//ֻڳʱȡ
+		CopHotKeyDetector<Key> detector_;
+	};
+
+}// coloop
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+
+#include "CopFlatMap.h"
+
+namespace CopCache {
+
+	//:ھڵʵֺͷƬϣ
+	//ûֽڵĿƽ(IDṹ)Ҳ16ֽʱʹñƽ,
+	//ֽڹϣͱȽ;(std::string)std::unordered_map + std::hash
+	template <typename Key>
+	struct CopKeyTraits
+	{
+		static constexpr bool isFlat = std::has_unique_object_representations<Key>::value
+			&& std::is_default_constructible<Key>::value
+			&& sizeof(Key) <= 16;
+
+		template <typename Mapped>
+		using MapType = typename std::conditional<isFlat,
+			CopFlatMap<Key, Mapped>,
+			std::unordered_map<Key, Mapped>>::type;
+
+		//ڶλõĹϣ
+		static size_t hash(const Key& key)
+		{
+			return hash(key, std::integral_constant<bool, isFlat>());
+		}
+
+		//ƬʹôӵĹϣ,ڶλĹϣ,ͬһƬļڲλ
+		static size_t shardHash(const Key& key)
+		{
+			return shardHash(key, std::integral_constant<bool, isFlat>());
+		}
+
+	private:
+		static size_t hash(const Key& key, std::true_type)
+		{
+			return static_cast<size_t>(copIntHash(key));
+		}
+
+		static size_t hash(const Key& key, std::false_type)
+		{
+			return std::hash<Key>()(key);
+		}
+
+		static size_t shardHash(const Key& key, std::true_type)
+		{
+			return static_cast<size_t>(copIntHash(key, 0x5851F42D4C957F2DULL) >> 32);
+		}
+
+		static size_t shardHash(const Key& key, std::false_type)
+		{
+			return std::hash<Key>()(key);
+		}
+	};
+
+	//һռõֽ,дصͼ¼ʹ켣
+	template <typename T>
+	size_t copPayloadBytes(const T&)
+	{
+		return sizeof(T);
+	}
+
+	inline size_t copPayloadBytes(const std::string& data)
+	{
+		return sizeof(std::string) + data.size();
+	}
+
+}// coloop
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "CopCachePolicy.h"
+#include "CopKeyTraits.h"
+
+namespace CopCache {
+
+	//߳˽еĶ·һ,Ƭ(CopShardedCache)ǰ
+	//ÿĿʱڷƬİ汾,ʱƬǰ汾Ƚ,һ¼;
+	//·̵ֻ߳ıһԭӰ汾,Ҳдڴ
+	//дֱдƬ,ɷƬ汾ʹ̵߳ľĿʧЧ
+	//SetsΪ,Ϊ2;ͬ͵Ķʵÿ̵߳һű,ʵĿ
+	template <typename Key, typename Value, typename Sharded, size_t Sets = 128>
+	class CopL1FrontCache : public CopCachePolicy<Key, Value>
+	{
+		static_assert((Sets & (Sets - 1)) == 0, "Sets must be a power of two");
+
+	public:
+		explicit CopL1FrontCache(Sharded& backend)
+			:backend_(backend)
+			, id_(nextId())
+		{}
+
+		~CopL1FrontCache() override = default;
+
+		//дƬ,һ
+		void put(Key key, Value value) override
+		{
+			backend_.put(key, value);
+		}
+
+		bool get(Key key, Value& value) override
+		{
+			size_t slice = backend_.sliceIndexOf(key);
+			//ȶ汾ٶ,֤ĿȰ汾
+			uint64_t version = backend_.sliceVersion(slice);
+			Set& set = localTable()[setIndex(key)];
+			for (int way = 0; way < 2; ++way)
+			{
+				Entry& entry = set.ways[way];
+				if (entry.owner == id_ && entry.version == version && entry.key == key)
+				{
+					value = entry.value;
+					set.recent = way;
+					return true;
+				}
+			}
+
+			if (!backend_.get(key, value))
+				return false;
+
+			//滻Ͼδõһ·
+			int victim = 1 - set.recent;
+			Entry& entry = set.ways[victim];
+			entry.owner = id_;
+			entry.version = version;
+			entry.key = key;
+			entry.value = value;
+			set.recent = victim;
+			return true;
+		}
+
+		Value get(Key key) override
+		{
+			Value value{};
+			get(key, value);
+			return value;
+		}
+
+		Sharded& backend() { return backend_; }
+
+	private:
+		struct Entry
+		{
+			uint64_t owner = 0;//ʵ,0ʾ
+			uint64_t version = 0;//ʱķƬ汾
+			Key key{};
+			Value value{};
+		};
+
+		struct Set
+		{
+			Entry ways[2];
+			int recent = 0;//ʹõһ·
+		};
+
+		//Ƭϣ:˷ɢкȡλΪ
+		static size_t setIndex(const Key& key)
+		{
+			uint64_t h = static_cast<uint64_t>(CopKeyTraits<Key>::hash(key)) * 0x9E3779B97F4A7C15ULL;
+			return static_cast<size_t>(h >> 40) & (Sets - 1);
+		}
+
+		static Set* localTable()
+		{
+			thread_local Set table[Sets];
+			return table;
+		}
+
+		static uint64_t nextId()
+		{
+			static std::atomic<uint64_t> counter(0);
+			return ++counter;
+		}
+
+	private:
+		Sharded& backend_;//
+		uint64_t id_;//ʵ,ٺַͬʵĿ
+	};
+
+}// coloop
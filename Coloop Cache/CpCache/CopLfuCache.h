@@ -1,18 +1,29 @@
 #pragma once
 
+#include <climits>
 #include <cmath>
+#include <cstdint>
 #include <memory>
 #include <mutex>
+#include <shared_mutex>
 #include <thread>
 #include <unordered_map>
 #include <vector>
 
 #include "CopCachePolicy.h"
+#include "CopCompute.h"
+#include "CopEvictionListener.h"
+#include "CopLockPolicy.h"
+#include "CopLockProfiler.h"
+#include "CopFileTier.h"
+#include "CopGeneration.h"
+#include "CopKeyTraits.h"
+#include "CopShardedCache.h"
 
 namespace CopCache {
 
 	//ǰlfuΪģ
-	template <typename Key, typename Value> class CopLfuCache;
+	template <typename Key, typename Value, typename LockPolicy> class CopLfuCache;
 
 	template <typename Key,typename Value>
 	class FreqList//Ƶ˫
@@ -24,15 +35,17 @@ namespace CopCache {
 			int freq;//Ƶ
 			Key key;
 			Value value;
+			uint64_t stamp;//дʱʧЧʱ
+			CopTag tag;//ǩ
 			std::shared_ptr<Node> pre;
 			std::shared_ptr<Node> next;//ָڵָ룬ṩǰͺָ룬Ϊ˫Ҫ
 
 			//ṩNode޲ι캯,ʼб
 			Node()
-				:freq(1),pre(nullptr),next(nullptr){}
+				:freq(1),stamp(0),tag(0),pre(nullptr),next(nullptr){}
 			//вι캯
 			Node(Key key,Value value)
-				:freq(1),key(key),value(value),pre(nullptr),next(nullptr){}
+				:freq(1),key(key),value(value),stamp(0),tag(0),pre(nullptr),next(nullptr){}
 		};
 		using NodePtr = std::shared_ptr<Node>;//ʹNodeptr湹ָĴ,Nodeڵָ
 		int freq_;//ע⣬Ȼÿڵ㶼Լķʴķʴķʴ
@@ -50,6 +63,23 @@ namespace CopCache {
 
 		}
 
+		//ڵ֮shared_ptr˫,,ֻɾͷŲκνڵ;
+		//ʱϿǰͺ,ڱϵĽڵܱͷ
+		~FreqList()
+		{
+			NodePtr node = head_;
+			while (node)
+			{
+				NodePtr next = node->next;
+				node->pre = nullptr;
+				node->next = nullptr;
+				node = next;
+			}
+		}
+
+		FreqList(const FreqList&) = delete;
+		FreqList& operator=(const FreqList&) = delete;
+
 		bool isEmpty() const//жǷΪ
 		{
 			return head_->next == tail_;
@@ -86,7 +116,7 @@ namespace CopCache {
 			return head_->next;
 		}
 
-		friend class CopLfuCache<Key, Value>;
+		template <typename K, typename V, typename L> friend class CopLfuCache;
 		//lfuӵƵΪԪ
 
 
@@ -95,57 +125,97 @@ namespace CopCache {
 
 	};
 
-	template <typename Key,typename Value>
-	class CopLfuCache :public CopCachePolicy<Key, Value>
+	//LockPolicyͬʽ(CopLockPolicy.h)
+	template <typename Key,typename Value,typename LockPolicy = CopMutexLock>
+	class CopLfuCache :public CopCachePolicy<Key, Value>,
+		public CopComputeOps<CopLfuCache<Key, Value, LockPolicy>, Key, Value>
 	{
 	public:
 		//
 		using Node = typename FreqList<Key, Value>::Node;//ƵеĽڵ㹹캯	
 		using NodePtr = std::shared_ptr<Node>;//ҪдڵָĴ
-		using NodeMap = std::unordered_map<Key, NodePtr>;//ڵϣ
+		using NodeMap = typename CopKeyTraits<Key>::template MapType<NodePtr>;//ڵϣ,ʹñƽ
+		using TierPtr = std::shared_ptr<CopFileTier<Key, Value>>;//ļָ
+		using ListenerPtr = std::shared_ptr<CopEvictionListener<Key, Value>>;//Ƴ
 
 		//캯,ƽƵΣҽʼƽƵκͷƵܺΪ0
 		CopLfuCache(int capacity,int maxAverageNum = 10)
-			:capacity_(capacity),minFreq_(INT8_MAX),maxAverageNum_(maxAverageNum),
+			:capacity_(capacity),minFreq_(INT_MAX),maxAverageNum_(maxAverageNum),
 			curAverageNum_(0),curTotalNum_(0)
 		{}
 
-		~CopLfuCache() override = default;//ʹĬ
+		//Ƶָ,ʱҪͷ
+		~CopLfuCache() override
+		{
+			for (auto& pair : freqToFreqList_)
+				delete pair.second;
+		}
 
 		void put(Key key, Value value) override
 		{
-			if (capacity_ == 0)
-				return;
+			put(key, value, 0);
+		}
 
-			//߳
-			std::lock_guard <std::mutex> lock(mutex_);
-			auto it = nodeMap_.find(key);
-			//ڹϣܹҵӦڵ
-			if (it != nodeMap_.end())
+		//ǩд,֮invalidateTagʹñǩµʧЧ
+		void put(Key key, Value value, CopTag tag)
+		{
+			CopLockOpScope opScope(CopLockOp::Put);
+			CopRemovalBatch<Key, Value> removed;
 			{
-				//½ڵֵ
-				it->second->value = value;
-
-				//ΪҪһηʴ
-				getInternal(it->second, value);
-				return;
-
+				//߳
+				std::lock_guard<LockPolicy> lock(mutex_);
+				//ܱsetCapacityߵ,Ҫж
+				if (capacity_ <= 0)
+					return;
+				auto it = nodeMap_.find(key);
+				//ڹϣܹҵӦڵ
+				if (it != nodeMap_.end())
+				{
+					//½ڵֵ,ֵΪ֪ͨ
+					removals_.push(key, it->second->value, CopRemovalCause::Replaced);
+					it->second->value = value;
+					it->second->stamp = generations_.stamp();
+					it->second->tag = tag;
+
+					//ΪҪһηʴ
+					getInternal(it->second, value);
+				}
+				else
+				{
+					putInternal(key, value, tag);
+				}
+				//ļľɸѹʱ,ɾ֮δʱ
+				if (victimTier_)
+					victimTier_->erase(key);
+				removed = removals_.drain();
 			}
-
-			putInternal(key, value);
+			//ص
+			removed.deliver();
 		}
 
 
 		bool get(Key key, Value& value) override
 		{
-			std::lock_guard <std::mutex> lock(mutex_);
-			auto it = nodeMap_.find(key);
-			if (it != nodeMap_.end()) {
-				//value޸ĺ󴫳
-				getInternal(it->second, value);
-				return true;
+			CopLockOpScope opScope(CopLockOp::Get);
+			TierPtr tier;
+			CopRemovalBatch<Key, Value> removed;
+			{
+				std::lock_guard<LockPolicy> lock(mutex_);
+				auto it = nodeMap_.find(key);
+				if (it != nodeMap_.end() && !isStale(it->second)) {
+					//value޸ĺ󴫳
+					getInternal(it->second, value);
+					return true;
+				}
+				//ʧЧΪδ,˳
+				if (it != nodeMap_.end())
+					expireNode(it->second);
+				tier = victimTier_;
+				removed = removals_.drain();
 			}
-			return false;
+			removed.deliver();
+			//ڴδʱļ,кڴ
+			return tier && tier->take(key, value) && promote(key, value);
 		}
 
 		Value get(Key key) override
@@ -156,21 +226,193 @@ namespace CopCache {
 		}
 
 
-		//ջ棬սڵϣƵƵϣ
+		//ԭӶд:ȡصдһμһβ,Ƶֻһ(CopCompute.h)
+		//صִ,ٷʱ;ڴûʱȴļȡ,еļԭǩ
+		template <typename Fn>
+		bool compute(Key key, Fn fn)
+		{
+			CopLockOpScope opScope(CopLockOp::Put);
+			bool present = false;
+			CopRemovalBatch<Key, Value> removed;
+			{
+				std::lock_guard<LockPolicy> lock(mutex_);
+				if (capacity_ <= 0)
+					return false;
+				auto it = nodeMap_.find(key);
+				if (it != nodeMap_.end() && isStale(it->second))
+				{
+					expireNode(it->second);
+					it = nodeMap_.end();
+				}
+				Value value{};
+				if (it == nodeMap_.end() && victimTier_ && victimTier_->take(key, value))
+				{
+					putInternal(key, value);
+					it = nodeMap_.find(key);
+				}
+				bool found = it != nodeMap_.end();
+				NodePtr node = found ? it->second : nullptr;
+				if (found)
+					value = node->value;
+
+				CopComputeAction action = fn(value, found);
+				if (action == CopComputeAction::Store)
+				{
+					if (found)
+					{
+						removals_.push(key, node->value, CopRemovalCause::Replaced);
+						node->value = value;
+						node->stamp = generations_.stamp();
+						getInternal(node, value);
+					}
+					else
+					{
+						putInternal(key, value);
+					}
+					present = true;
+				}
+				else if (action == CopComputeAction::Remove)
+				{
+					if (found)
+						eraseNode(node, CopRemovalCause::Explicit);
+					if (victimTier_)
+						victimTier_->erase(key);
+				}
+				else
+				{
+					if (found)
+						getInternal(node, value);
+					present = found;
+				}
+				removed = removals_.drain();
+			}
+			removed.deliver();
+			return present;
+		}
+
+		//ֻ:ӷƵ,д¿Բִ
+		bool contains(Key key)
+		{
+			std::shared_lock<LockPolicy> lock(mutex_);
+			auto it = nodeMap_.find(key);
+			return it != nodeMap_.end() && !isStale(it->second);
+		}
+
+		bool peek(Key key, Value& value)
+		{
+			std::shared_lock<LockPolicy> lock(mutex_);
+			auto it = nodeMap_.find(key);
+			if (it == nodeMap_.end() || isStale(it->second))
+				return false;
+			value = it->second->value;
+			return true;
+		}
+
+		//ߵ;ʱCopResizeStep߳ڵ,ͷ
+		void setCapacity(size_t capacity);
+
+		//̨άģʽ:put೬slackڵ߳,ƵϻҲƳٵmaintain;0Ϊر(Ĭ)
+		void setMaintenanceSlack(size_t slack)
+		{
+			std::lock_guard<LockPolicy> lock(mutex_);
+			slack_ = slack;
+		}
+
+		//̨ά:ˮλ߳,ִƳٵƵϻʧЧڵ,شĽڵ
+		//߳ͻÿָദmaxStepsڵ,ûһ
+		size_t maintain(size_t maxSteps = CopResizeStep);
+
+		size_t capacity()
+		{
+			std::shared_lock<LockPolicy> lock(mutex_);
+			return capacity_;
+		}
+
+		size_t size()
+		{
+			std::shared_lock<LockPolicy> lock(mutex_);
+			return nodeMap_.size();
+		}
+
+		//ͳ,LockPolicyΪCopProfiledLockҶCOP_LOCK_PROFILINGʱ
+		CopLockStats lockStats() const
+		{
+			return copLockStats(mutex_);
+		}
+
+		//öļ,߳Ľڵдò
+		void setVictimTier(TierPtr tier)
+		{
+			std::lock_guard<LockPolicy> lock(mutex_);
+			victimTier_ = tier;
+		}
+
+		//Ƴ,߳򸲸ǵĽڵ֪ͨ
+		void setRemovalListener(ListenerPtr listener)
+		{
+			std::lock_guard<LockPolicy> lock(mutex_);
+			removals_.setListener(listener);
+		}
+
+		//O(1)ʹȫʧЧ,ڽڵڷʡ߳sweepStaleʱ
+		void invalidateAll()
+		{
+			std::lock_guard<LockPolicy> lock(mutex_);
+			generations_.invalidateAll();
+			if (victimTier_)
+				victimTier_->clear();
+		}
+
+		//O(1)ʹĳǩµȫʧЧ
+		void invalidateTag(CopTag tag)
+		{
+			std::lock_guard<LockPolicy> lock(mutex_);
+			generations_.invalidateTag(tag);
+		}
+
+		//ɨ:ظƵϴͣµλmaxStepsڵ,ػ
+		size_t sweepStale(size_t maxSteps = CopResizeStep);
+
+		//ջ,O(n)ȫ̳;ֻҪʧЧʱʹinvalidateAll
+		//ÿݶƳ֪ͨ,ʧЧδɨİExpired,ఴExplicit
 		void purge()
 		{
-			nodeMap_.clear();
-			freqToFreqList_.clear();
+			CopRemovalBatch<Key, Value> removed;
+			{
+				std::lock_guard<LockPolicy> lock(mutex_);
+				for (auto& pair : nodeMap_)
+					removals_.push(pair.first, pair.second->value,
+						isStale(pair.second) ? CopRemovalCause::Expired : CopRemovalCause::Explicit);
+				nodeMap_.clear();
+				for (auto& pair : freqToFreqList_)
+					delete pair.second;
+				freqToFreqList_.clear();
+				sweepCursor_ = nullptr;
+				minFreq_ = INT_MAX;
+				curAverageNum_ = 0;
+				curTotalNum_ = 0;
+				removed = removals_.drain();
+			}
+			removed.deliver();
 		}
 
 
 
 	private:
 		//ʵ֣֮Ⱥ˵ԼҪã
-		void putInternal(Key key, Value value);//ӻ
+		void putInternal(Key key, Value value, CopTag tag = 0);//ӻ
 		void getInternal(NodePtr node, Value& value);//ȡ
+		bool promote(Key key, Value& value);//ļڴ
 
 		void kickOut();//ƳеĹ
+		size_t evictDownTo(size_t target, size_t maxSteps = SIZE_MAX);//߳targetڵ,߳maxSteps
+		void expireNode(NodePtr node);//һʧЧĽڵ
+		void eraseNode(NodePtr node, CopRemovalCause cause);//Ƴڵ㲢֪ͨ
+
+		bool isStale(const NodePtr& node) const
+		{
+			return generations_.isStale(node->stamp, node->tag);
+		}
 
 		void removeFromFreqList(NodePtr node);//ƵƳڵ
 
@@ -193,17 +435,24 @@ namespace CopCache {
 		int maxAverageNum_;//ƽƵ
 		int curAverageNum_;//ǰƽƵ
 		int curTotalNum_;//ǰзƵ
-		std::mutex mutex_;
+		LockPolicy mutex_;//,ģ
 		NodeMap nodeMap_;
+		TierPtr victimTier_;//ļ,Ϊ
+		CopRemovalQueue<Key, Value> removals_;//ڼܵƳ֪ͨ
 		std::unordered_map<int, FreqList<Key, Value>*> freqToFreqList_;//ƵζԸ÷Ƶӳϣ
+		CopGenerations generations_;//ʧЧ
+		NodePtr sweepCursor_;//ɨĵǰڵ
+		int sweepFreq_ = 0;//ɨλڵƵ
+		size_t slack_ = 0;//̨άģʽĽڵ
+		bool agingPending_ = false;//̨άģʽ´ִеƵϻ
 		
 	};
 
 	//ʵֺ
 
 	//ȡڵֵ
-	template <typename Key,typename Value>
-	void CopLfuCache<Key, Value> ::getInternal(NodePtr node, Value& value)
+	template <typename Key, typename Value, typename LockPolicy>
+	void CopLfuCache<Key, Value, LockPolicy> ::getInternal(NodePtr node, Value& value)
 	{
 		//lruͬlfuȡڵҪƳǰڵ㣬ҽýڵƶ+1ķƵ
 		// ȡֵ
@@ -224,17 +473,19 @@ namespace CopCache {
 	}
 
 	//ڵ㵽
-	template <typename Key, typename Value>
-	void CopLfuCache<Key, Value> ::putInternal(Key key, Value value)
+	template <typename Key, typename Value, typename LockPolicy>
+	void CopLfuCache<Key, Value, LockPolicy> ::putInternal(Key key, Value value, CopTag tag)
 	{
 		//putʱڵδڻУҪ뻺
-		if (nodeMap_.size() == capacity_)
+		if (nodeMap_.size() >= static_cast<size_t>(capacity_) + slack_)
 		{
-			//ʱҪڵ
+			//ʱҪڵ(̨άģʽ³ž͵)
 			kickOut();
 		}
 		//ڵ㲢ڵϣ
 		NodePtr node = std::make_shared<Node>(key, value);
+		node->stamp = generations_.stamp();
+		node->tag = tag;
 		nodeMap_[key] = node;
 		addToFreqList(node);
 		//ҸзƵ͵ǰƽƵ
@@ -244,33 +495,183 @@ namespace CopCache {
 
 	}
 
+	template <typename Key, typename Value, typename LockPolicy>
+	void CopLfuCache<Key, Value, LockPolicy> ::setCapacity(size_t capacity)
+	{
+		{
+			std::lock_guard<LockPolicy> lock(mutex_);
+			capacity_ = static_cast<int>(capacity);
+		}
+		evictDownTo(capacity);
+	}
+
+	template <typename Key, typename Value, typename LockPolicy>
+	size_t CopLfuCache<Key, Value, LockPolicy> ::evictDownTo(size_t target, size_t maxSteps)
+	{
+		size_t evicted = 0;
+		bool done = false;
+		while (!done)
+		{
+			CopRemovalBatch<Key, Value> removed;
+			{
+				std::lock_guard<LockPolicy> lock(mutex_);
+				for (size_t i = 0; i < CopResizeStep && evicted < maxSteps && nodeMap_.size() > target; ++i, ++evicted)
+				{
+					kickOut();
+					//Ƶ߿պҪСƵ
+					auto minList = freqToFreqList_[minFreq_];
+					if (!minList || minList->isEmpty())
+						updateMinFreq();
+				}
+				done = nodeMap_.size() <= target || evicted >= maxSteps;
+				removed = removals_.drain();
+			}
+			removed.deliver();
+		}
+		return evicted;
+	}
+
+	template <typename Key, typename Value, typename LockPolicy>
+	size_t CopLfuCache<Key, Value, LockPolicy> ::maintain(size_t maxSteps)
+	{
+		size_t lowWater;
+		{
+			std::lock_guard<LockPolicy> lock(mutex_);
+			size_t capacity = static_cast<size_t>(std::max(capacity_, 0));
+			lowWater = capacity - std::min(capacity, slack_ / 2);
+		}
+		size_t work = evictDownTo(lowWater, maxSteps);
+		{
+			std::lock_guard<LockPolicy> lock(mutex_);
+			if (agingPending_)
+			{
+				agingPending_ = false;
+				handleOverMaxAverageNum();
+				work += nodeMap_.size();
+			}
+		}
+		return work + sweepStale(maxSteps);
+	}
+
+	//ļڴ,ڼѱдڴеֵΪ׼
+	template <typename Key, typename Value, typename LockPolicy>
+	bool CopLfuCache<Key, Value, LockPolicy> ::promote(Key key, Value& value)
+	{
+		CopRemovalBatch<Key, Value> removed;
+		{
+			std::lock_guard<LockPolicy> lock(mutex_);
+			auto it = nodeMap_.find(key);
+			if (it != nodeMap_.end() && !isStale(it->second))
+				getInternal(it->second, value);
+			else
+			{
+				if (it != nodeMap_.end())
+					expireNode(it->second);
+				putInternal(key, value);
+			}
+			removed = removals_.drain();
+		}
+		removed.deliver();
+		return true;
+	}
+
 	//õĽڵ
-	template <typename Key, typename Value>
-	void CopLfuCache<Key, Value> ::kickOut()
+	template <typename Key, typename Value, typename LockPolicy>
+	void CopLfuCache<Key, Value, LockPolicy> ::kickOut()
 	{
+		copLockNote(CopLockOp::Evict);
 		//ȡзƵʱõĽڵ㣬ɾ·Ƶƽֵ
 		NodePtr node = freqToFreqList_[minFreq_]->getFirstNode();
 		removeFromFreqList(node);
 		nodeMap_.erase(node->key);
 		decreaseFreqNum(node->freq);
+		bool stale = isStale(node);
+		removals_.push(node->key, node->value, stale ? CopRemovalCause::Expired : CopRemovalCause::Capacity);
+		//ļʱ,߳Ľڵ³ļ;ļ㲻¼ǩ,ǩѹڵĽڵֱӶ
+		if (victimTier_ && !stale && node->tag == 0)
+			victimTier_->store(node->key, node->value);
+
+	}
+
+	template <typename Key, typename Value, typename LockPolicy>
+	void CopLfuCache<Key, Value, LockPolicy> ::expireNode(NodePtr node)
+	{
+		eraseNode(node, CopRemovalCause::Expired);
+	}
+
+	template <typename Key, typename Value, typename LockPolicy>
+	void CopLfuCache<Key, Value, LockPolicy> ::eraseNode(NodePtr node, CopRemovalCause cause)
+	{
+		removeFromFreqList(node);
+		nodeMap_.erase(node->key);
+		decreaseFreqNum(node->freq);
+		removals_.push(node->key, node->value, cause);
+		//ƵȡʱСƵ,֤kickOutȡڵ
+		if (node->freq == minFreq_ && freqToFreqList_[minFreq_]->isEmpty())
+			updateMinFreq();
+	}
 
+	template <typename Key, typename Value, typename LockPolicy>
+	size_t CopLfuCache<Key, Value, LockPolicy> ::sweepStale(size_t maxSteps)
+	{
+		size_t reclaimed = 0;
+		CopRemovalBatch<Key, Value> removed;
+		{
+			std::lock_guard<LockPolicy> lock(mutex_);
+			if (!generations_.hasInvalidations())
+				return 0;
+			for (size_t i = 0; i < maxSteps && !nodeMap_.empty(); ++i)
+			{
+				auto listIt = freqToFreqList_.find(sweepFreq_);
+				if (!sweepCursor_ || listIt == freqToFreqList_.end() || sweepCursor_ == listIt->second->tail_)
+				{
+					//ǰɨ,һߵƵ,ûصƵ
+					int nextFreq = INT_MAX;
+					int lowestFreq = INT_MAX;
+					for (const auto& pair : freqToFreqList_)
+					{
+						if (pair.second->isEmpty())
+							continue;
+						lowestFreq = std::min(lowestFreq, pair.first);
+						if (pair.first > sweepFreq_)
+							nextFreq = std::min(nextFreq, pair.first);
+					}
+					sweepFreq_ = nextFreq != INT_MAX ? nextFreq : lowestFreq;
+					sweepCursor_ = freqToFreqList_[sweepFreq_]->getFirstNode();
+					continue;
+				}
+				NodePtr node = sweepCursor_;
+				sweepCursor_ = node->next;
+				if (isStale(node))
+				{
+					expireNode(node);
+					++reclaimed;
+				}
+			}
+			removed = removals_.drain();
+		}
+		removed.deliver();
+		return reclaimed;
 	}
 
 	//ƳӦڵ
-	template <typename Key, typename Value>
-	void CopLfuCache<Key, Value> ::removeFromFreqList(NodePtr node)
+	template <typename Key, typename Value, typename LockPolicy>
+	void CopLfuCache<Key, Value, LockPolicy> ::removeFromFreqList(NodePtr node)
 	{
 		//ڵΪ򲻴
 		if (!node)
 			return;
+		//ɨλڱߵĽڵʱ˳ӵͬһһ
+		if (node == sweepCursor_)
+			sweepCursor_ = node->next;
 		//freqListĺڵ
 		auto freq = node->freq;
 		freqToFreqList_[freq]->removeNode(node);
 	}
 
 	//ӽڵ㵽
-	template <typename Key, typename Value>
-	void CopLfuCache<Key, Value> ::addToFreqList(NodePtr node)
+	template <typename Key, typename Value, typename LockPolicy>
+	void CopLfuCache<Key, Value, LockPolicy> ::addToFreqList(NodePtr node)
 	{
 		if (!node)
 			return;
@@ -286,8 +687,8 @@ namespace CopCache {
 	}
 
 	//Ƶƽ
-	template <typename Key, typename Value>
-	void CopLfuCache<Key, Value> ::addFreqNum()
+	template <typename Key, typename Value, typename LockPolicy>
+	void CopLfuCache<Key, Value, LockPolicy> ::addFreqNum()
 	{
 		//ǰ
 		curTotalNum_++;
@@ -297,16 +698,19 @@ namespace CopCache {
 		else
 			curAverageNum_ = curTotalNum_ / nodeMap_.size();
 
-		//ǰƽƵѾƣ
+		//ǰƽƵѾƣ;̨άģʽ½maintain
 		if (curAverageNum_ > maxAverageNum_)
 		{
-			handleOverMaxAverageNum();
+			if (slack_ > 0)
+				agingPending_ = true;
+			else
+				handleOverMaxAverageNum();
 		}
 	}
 
 	//ӦЩֵ
-	template <typename Key, typename Value>
-	void CopLfuCache<Key, Value> ::decreaseFreqNum(int num)
+	template <typename Key, typename Value, typename LockPolicy>
+	void CopLfuCache<Key, Value, LockPolicy> ::decreaseFreqNum(int num)
 	{
 		//ƽƵκܷƵ
 		curTotalNum_ -= num;
@@ -319,14 +723,16 @@ namespace CopCache {
 	}
 
 	//ƽֵѾ
-	template <typename Key, typename Value>
-	void CopLfuCache<Key, Value> ::handleOverMaxAverageNum()
+	template <typename Key, typename Value, typename LockPolicy>
+	void CopLfuCache<Key, Value, LockPolicy> ::handleOverMaxAverageNum()
 	{
 		if (nodeMap_.empty())
 			return;
+		copLockNote(CopLockOp::Aging);
 
 		//ΪǰƽƵγƽƵƣнڵķƵλȥ(maxAVerageNum_/2)
-		//нڵ
+		//нڵ,ͬʱͳƵ,ƽֵһֱ,֮ÿηʶϻ
+		curTotalNum_ = 0;
 		for (auto it = nodeMap_.begin(); it != nodeMap_.end(); ++it) {
 
 			if (!it->second)
@@ -343,15 +749,17 @@ namespace CopCache {
 
 			//ӵµƵ
 			addToFreqList(node);
+			curTotalNum_ += node->freq;
 		}
+		curAverageNum_ = curTotalNum_ / static_cast<int>(nodeMap_.size());
 		//ɺСƵ
 		updateMinFreq();
 	}
 
-	template <typename Key, typename Value>
-	void CopLfuCache<Key, Value> ::updateMinFreq()
+	template <typename Key, typename Value, typename LockPolicy>
+	void CopLfuCache<Key, Value, LockPolicy> ::updateMinFreq()
 	{
-		minFreq_ = INT8_MAX;
+		minFreq_ = INT_MAX;
 		//ɨнڵ㣬³СƵ
 		for (const auto& pair : freqToFreqList_)
 		{
@@ -361,65 +769,27 @@ namespace CopCache {
 			}
 		}
 
-		if (minFreq_ == INT8_MAX)
+		if (minFreq_ == INT_MAX)
 			minFreq_ = 1;
 	}
 
 
 	//lruͬƬ߲б̵Ч
-	template<typename Key,typename Value>
-	class CopHashLfuCache
+	template<typename Key,typename Value,typename LockPolicy = CopMutexLock>
+	class CopHashLfuCache : public CopShardedCache<Key, Value, CopLfuCache<Key, Value, LockPolicy>>
 	{
 	public:
-		//캯
+		//캯,maxAverageNumÿlfuƬ
 		CopHashLfuCache(size_t capacity, int sliceNum, int maxAverageNum = 10)
-			:sliceNum_(sliceNum > 0 ? sliceNum : std::thread::hardware_concurrency())
-			, capacity_(capacity)
-		{
-			size_t sliceSize = std::ceil(capacity_ / static_cast<double>(sliceNum_));//ÿlfuƬСȡ
-			for (int i = 0; i < sliceNum_; ++i) {
-				//ͬҪƬӦĻƬָ
-				lfuSliceCaches_.emplace_back(new CopLfuCache<Key, Value>(sliceSize, maxAverageNum));
-			}
-		}
-
-		void put(Key key, Value value)
-		{
-			//keyĹϣֵɹϣ޸ģӣڵ
-			size_t sliceIndex = Hash(key) % sliceNum_;
-			return lfuSliceCaches_[sliceIndex]->put(key, value);
-		}
-
-		bool get(Key key, Value& value)
-		{
-			//ͬλȡӦڵֵ
-			size_t sliceIndex = Hash(key) % sliceNum_;
-			return lfuSliceCaches_[sliceIndex]->get(key, value);
-		}
-
-		Value get(Key key) {
-			Value value;
-			get(key, value);
-			return value;
-		}
+			:CopShardedCache<Key, Value, CopLfuCache<Key, Value, LockPolicy>>(capacity, sliceNum, maxAverageNum)
+		{}
 
 		//Ƭл(ڵϣƵƵϣ)
 		void purge()
 		{
-			for (auto& lfuSlice : lfuSliceCaches_)
+			for (auto& lfuSlice : this->slices_)
 				lfuSlice->purge();
 		}
-			
-	private:
-		//keyֵתɶӦĹϣֵ
-		size_t Hash(Key key) {
-			std::hash <Key> hashFunc;
-			return hashFunc(key);
-		}
-	private:
-		size_t capacity_;//
-		int sliceNum_;//Ƭ
-		std::vector<std::unique_ptr<CopLfuCache<Key, Value>>> lfuSliceCaches_;//ƬĴ洢
 	};
 
 
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+
+namespace CopCache {
+
+	//:Ϊģ,дstd::mutex
+	//ÿṩlock/unlock/try_locklock_shared/unlock_shared,
+	//˿ֱstd::lock_guardstd::shared_lockʹ
+
+	//,ֻڲᱻ̹߳Ļ(߳˽л)
+	class CopNullLock
+	{
+	public:
+		void lock() {}
+		void unlock() {}
+		bool try_lock() { return true; }
+		void lock_shared() {}
+		void unlock_shared() {}
+	};
+
+	//Ĭϲ,ͨ;ֻҲʹöռ
+	class CopMutexLock
+	{
+	public:
+		void lock() { mutex_.lock(); }
+		void unlock() { mutex_.unlock(); }
+		bool try_lock() { return mutex_.try_lock(); }
+		void lock_shared() { mutex_.lock(); }
+		void unlock_shared() { mutex_.unlock(); }
+
+	private:
+		std::mutex mutex_;
+	};
+
+	//Ӧ:һСʱ,òٹȴ
+	//ٽܶʱ߳л,ʱϳʱֲתCPU
+	class CopSpinParkLock
+	{
+	public:
+		explicit CopSpinParkLock(int spinCount = 128)
+			:locked_(false)
+			, waiters_(0)
+			, spinCount_(spinCount)
+		{}
+
+		void lock()
+		{
+			for (int i = 0; i < spinCount_; ++i)
+			{
+				if (try_lock())
+					return;
+				if (i >= spinCount_ / 2)
+					std::this_thread::yield();
+			}
+			//ʧ,ȴ
+			std::unique_lock<std::mutex> parkLock(parkMutex_);
+			++waiters_;
+			parkCv_.wait(parkLock, [this] { return try_lock(); });
+			--waiters_;
+		}
+
+		void unlock()
+		{
+			locked_.store(false);
+			//й̲߳Ҫ
+			if (waiters_.load() > 0)
+			{
+				std::lock_guard<std::mutex> parkLock(parkMutex_);
+				parkCv_.notify_one();
+			}
+		}
+
+		bool try_lock()
+		{
+			return !locked_.load(std::memory_order_relaxed) && !locked_.exchange(true, std::memory_order_acquire);
+		}
+
+		void lock_shared() { lock(); }
+		void unlock_shared() { unlock(); }
+
+	private:
+		std::atomic<bool> locked_;
+		std::atomic<int> waiters_;//߳
+		int spinCount_;
+		std::mutex parkMutex_;
+		std::condition_variable parkCv_;
+	};
+
+	//д:contains/peekֻʹù,Բִ
+	class CopSharedLock
+	{
+	public:
+		void lock() { mutex_.lock(); }
+		void unlock() { mutex_.unlock(); }
+		bool try_lock() { return mutex_.try_lock(); }
+		void lock_shared() { mutex_.lock_shared(); }
+		void unlock_shared() { mutex_.unlock_shared(); }
+
+	private:
+		std::shared_mutex mutex_;
+	};
+
+}// coloop
@@ -0,0 +1,254 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace CopCache {
+
+	//÷:COP_LOCK_PROFILING,CopProfiledLock<Inner>ͳƼô
+	//ȴʱֲԼһγĲ;δʱCopProfiledLock<Inner>Inner,
+	//Ҳǿʵ,ͳƽΪ,κζ⿪
+
+	//ڼִеĲ
+	enum class CopLockOp : uint8_t
+	{
+		Other,
+		Put,
+		Get,
+		Evict,
+		Aging
+	};
+
+	//ʱֱͼͰ:iͰͳ[2^i, 2^(i+1)),һͰиʱ
+	constexpr int CopLockBuckets = 32;
+
+	struct CopLockStats
+	{
+		uint64_t acquisitions = 0;//
+		uint64_t contended = 0;//һγûõĴ
+		uint64_t waitHist[CopLockBuckets] = {};//ȴʱֲ
+		uint64_t holdHist[CopLockBuckets] = {};//ռʱֲ
+		uint64_t maxHoldNs = 0;//һζռ
+		CopLockOp maxHoldOp = CopLockOp::Other;//ڼĲ
+	};
+
+#ifdef COP_LOCK_PROFILING
+
+	namespace detail {
+		struct CopLockThreadOp
+		{
+			CopLockOp op = CopLockOp::Other;//(put/get)
+			CopLockOp note = CopLockOp::Other;//ڼ䷢̭ϻڲ
+		};
+
+		inline CopLockThreadOp& copLockThreadOp()
+		{
+			thread_local CopLockThreadOp state;
+			return state;
+		}
+	}
+
+	//ڼ֮ǰ,Ǳִ߳̽еĲ
+	class CopLockOpScope
+	{
+	public:
+		explicit CopLockOpScope(CopLockOp op)
+			:prev_(detail::copLockThreadOp().op)
+		{
+			detail::copLockThreadOp().op = op;
+		}
+
+		~CopLockOpScope() { detail::copLockThreadOp().op = prev_; }
+
+		CopLockOpScope(const CopLockOpScope&) = delete;
+		CopLockOpScope& operator=(const CopLockOpScope&) = delete;
+
+	private:
+		CopLockOp prev_;
+	};
+
+	//ڵ,ѱγ̭ϻڲ,ʱ
+	inline void copLockNote(CopLockOp op)
+	{
+		detail::copLockThreadOp().note = op;
+	}
+
+	template <typename Inner>
+	class CopProfiledLock
+	{
+	public:
+		CopProfiledLock()
+			:acquisitions_(0)
+			, contended_(0)
+			, maxHold_(0)
+			, holdStart_(0)
+		{
+			for (int i = 0; i < CopLockBuckets; ++i)
+			{
+				waitHist_[i].store(0, std::memory_order_relaxed);
+				holdHist_[i].store(0, std::memory_order_relaxed);
+			}
+		}
+
+		void lock()
+		{
+			uint64_t start = now();
+			if (!inner_.try_lock())
+			{
+				contended_.fetch_add(1, std::memory_order_relaxed);
+				inner_.lock();
+			}
+			onAcquired(start);
+		}
+
+		bool try_lock()
+		{
+			uint64_t start = now();
+			if (!inner_.try_lock())
+				return false;
+			onAcquired(start);
+			return true;
+		}
+
+		void unlock()
+		{
+			uint64_t hold = now() - holdStart_;
+			auto& state = detail::copLockThreadOp();
+			CopLockOp op = state.note != CopLockOp::Other ? state.note : state.op;
+			state.note = CopLockOp::Other;
+			inner_.unlock();
+
+			holdHist_[bucket(hold)].fetch_add(1, std::memory_order_relaxed);
+			//ʱͲһԭ,֤ʼճɶ
+			uint64_t packed = (hold << 8) | static_cast<uint64_t>(op);
+			uint64_t cur = maxHold_.load(std::memory_order_relaxed);
+			while (packed > cur && !maxHold_.compare_exchange_weak(cur, packed, std::memory_order_relaxed))
+			{
+			}
+		}
+
+		//ͬʱж,ֻͳƴ͵ȴʱ
+		void lock_shared()
+		{
+			uint64_t start = now();
+			inner_.lock_shared();
+			acquisitions_.fetch_add(1, std::memory_order_relaxed);
+			waitHist_[bucket(now() - start)].fetch_add(1, std::memory_order_relaxed);
+		}
+
+		void unlock_shared() { inner_.unlock_shared(); }
+
+		CopLockStats stats() const
+		{
+			CopLockStats result;
+			result.acquisitions = acquisitions_.load(std::memory_order_relaxed);
+			result.contended = contended_.load(std::memory_order_relaxed);
+			for (int i = 0; i < CopLockBuckets; ++i)
+			{
+				result.waitHist[i] = waitHist_[i].load(std::memory_order_relaxed);
+				result.holdHist[i] = holdHist_[i].load(std::memory_order_relaxed);
+			}
+			uint64_t packed = maxHold_.load(std::memory_order_relaxed);
+			result.maxHoldNs = packed >> 8;
+			result.maxHoldOp = static_cast<CopLockOp>(packed & 0xff);
+			return result;
+		}
+
+	private:
+		static uint64_t now()
+		{
+			return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count());
+		}
+
+		static int bucket(uint64_t ns)
+		{
+			int b = 0;
+			while (ns > 1 && b < CopLockBuckets - 1)
+			{
+				ns >>= 1;
+				++b;
+			}
+			return b;
+		}
+
+		void onAcquired(uint64_t start)
+		{
+			holdStart_ = now();
+			detail::copLockThreadOp().note = CopLockOp::Other;
+			acquisitions_.fetch_add(1, std::memory_order_relaxed);
+			waitHist_[bucket(holdStart_ - start)].fetch_add(1, std::memory_order_relaxed);
+		}
+
+	private:
+		Inner inner_;
+		std::atomic<uint64_t> acquisitions_;
+		std::atomic<uint64_t> contended_;
+		std::atomic<uint64_t> waitHist_[CopLockBuckets];
+		std::atomic<uint64_t> holdHist_[CopLockBuckets];
+		std::atomic<uint64_t> maxHold_;//56λΪ,8λΪ
+		uint64_t holdStart_;//ռʱ,ֻɳ̶߳д
+	};
+
+	template <typename Inner>
+	CopLockStats copLockStats(const CopProfiledLock<Inner>& lock)
+	{
+		return lock.stats();
+	}
+
+#else
+
+	class CopLockOpScope
+	{
+	public:
+		explicit CopLockOpScope(CopLockOp) {}
+	};
+
+	inline void copLockNote(CopLockOp) {}
+
+	template <typename Inner>
+	using CopProfiledLock = Inner;
+
+#endif
+
+	//δ÷ûͳ
+	template <typename Lock>
+	CopLockStats copLockStats(const Lock&)
+	{
+		return CopLockStats();
+	}
+
+	//otherͳƺϲinto,ɶɵĲ(ARC)
+	inline void copMergeLockStats(CopLockStats& into, const CopLockStats& other)
+	{
+		into.acquisitions += other.acquisitions;
+		into.contended += other.contended;
+		for (int i = 0; i < CopLockBuckets; ++i)
+		{
+			into.waitHist[i] += other.waitHist[i];
+			into.holdHist[i] += other.holdHist[i];
+		}
+		if (other.maxHoldNs > into.maxHoldNs)
+		{
+			into.maxHoldNs = other.maxHoldNs;
+			into.maxHoldOp = other.maxHoldOp;
+		}
+	}
+
+	namespace detail {
+		//ṩlockStats()ʱȡͳ,򷵻ؿͳ
+		template <typename Policy>
+		auto copPolicyLockStats(const Policy& policy, int) -> decltype(policy.lockStats())
+		{
+			return policy.lockStats();
+		}
+
+		template <typename Policy>
+		CopLockStats copPolicyLockStats(const Policy&, long)
+		{
+			return CopLockStats();
+		}
+	}
+
+}// coloop
@@ -1,17 +1,31 @@
 #pragma once
 
+# include <algorithm>
+# include <cmath>
+# include <cstdint>
 # include <cstring>
+# include <iterator>
 # include <list>
 # include <memory>
 # include <mutex>
+# include <shared_mutex>
+# include <thread>
 # include <unordered_map>
 # include <vector>
 
 #include "CopCachePolicy.h"
+#include "CopCompute.h"
+#include "CopEvictionListener.h"
+#include "CopLockPolicy.h"
+#include "CopLockProfiler.h"
+#include "CopFileTier.h"
+#include "CopGeneration.h"
+#include "CopKeyTraits.h"
+#include "CopShardedCache.h"
 
 namespace CopCache {
 	//ģ,ǰCopLruCacheеģ
-	template <typename Key, typename Value> class CopLruCache;
+	template <typename Key, typename Value, typename LockPolicy> class CopLruCache;
 	 
 	template <typename Key,typename Value>
 	class LruNode {
@@ -19,6 +33,8 @@ namespace CopCache {
 		Key key_;
 		Value value_;
 		size_t accessCount_; //ʴ
+		uint64_t stamp_;//дʱʧЧʱ
+		CopTag tag_;//ǩ
 		//ָ룬ָڵڱڵָ
 		std::shared_ptr<LruNode<Key, Value>> prev_;
 		std::shared_ptr<LruNode<Key, Value>> next_;
@@ -30,6 +46,8 @@ namespace CopCache {
 			: key_(key)
 			, value_(value)
 			, accessCount_(1)
+			, stamp_(0)
+			, tag_(0)
 			, prev_(nullptr)
 			, next_(nullptr)
 		{}
@@ -43,12 +61,13 @@ namespace CopCache {
 		void incrementAccessCount() { ++accessCount_; }//ӷʴֵ
 
 		//Ԫ
-		friend class CopLruCache<Key, Value>;
+		template <typename K, typename V, typename L> friend class CopLruCache;
 	};
 
-	//̳ģ岢ģ廯
-	template <typename Key,typename Value>
-	class CopLruCache : public CopCachePolicy<Key, Value>
+	//̳ģ岢ģ廯,LockPolicyͬʽ(CopLockPolicy.h)
+	template <typename Key,typename Value,typename LockPolicy = CopMutexLock>
+	class CopLruCache : public CopCachePolicy<Key, Value>,
+		public CopComputeOps<CopLruCache<Key, Value, LockPolicy>, Key, Value>
 	{
 
 	public:
@@ -56,8 +75,12 @@ namespace CopCache {
 		using LruNodeType = LruNode<Key, Value>;
 		//ָLruڵָ
 		using NodePtr = std::shared_ptr <LruNodeType>;
-		//ڵϣ,洢ָĹϵ
-		using NodeMap = std::unordered_map <Key, NodePtr>;
+		//ڵϣ,洢ָĹϵ;ڱڻɱƽ(CopKeyTraits.h)
+		using NodeMap = typename CopKeyTraits<Key>::template MapType<NodePtr>;
+		//ļָ
+		using TierPtr = std::shared_ptr<CopFileTier<Key, Value>>;
+		//Ƴ
+		using ListenerPtr = std::shared_ptr<CopEvictionListener<Key, Value>>;
 
 		//캯
 		CopLruCache(int capacity) 
@@ -71,37 +94,63 @@ namespace CopCache {
 		//ӻ溯
 		void put(Key key, Value value) override
 		{
-			if (capacity_ <= 0) 
-				return;
-			
-
-			//߳
-			std::lock_guard<std::mutex> lock(mutex_);
-
-			auto it = nodeMap_.find(key);
-			if (it != nodeMap_.end()) {
-				//Ѿдڣ
-				updateExistingNode(it->second, value);
-				return;
+			put(key, value, 0);
+		}
 
+		//ǩд,֮invalidateTagʹñǩµʧЧ
+		void put(Key key, Value value, CopTag tag)
+		{
+			CopLockOpScope opScope(CopLockOp::Put);
+			CopRemovalBatch<Key, Value> removed;
+			{
+				//߳
+				std::lock_guard<LockPolicy> lock(mutex_);
+				//ܱsetCapacityߵ,Ҫж
+				if (capacity_ <= 0)
+					return;
+
+				auto it = nodeMap_.find(key);
+				if (it != nodeMap_.end()) {
+					//Ѿдڣ
+					updateExistingNode(it->second, value, tag);
+				}
+				else {
+					//ڣ
+					addNewNode(key, value, tag);
+				}
+				//ļľɸѹʱ,ɾ֮δʱ
+				if (victimTier_)
+					victimTier_->erase(key);
+				removed = removals_.drain();
 			}
-			//ڣ
-			addNewNode(key, value);
+			//ص
+			removed.deliver();
 		}
 
 		//ȡڵֵ,bool ͿԱڷʲֵʱҪֵ
 		bool get(Key key, Value& value) override
 		{
-			std::lock_guard<std::mutex> lock(mutex_);
-			auto it = nodeMap_.find(key);
-			if (it != nodeMap_.end()) {
-				moveToMostRecent(it->second);
-				//üжӦڵ㣬ôõvalue޸ΪӦڵֵ
-				value = it->second->getValue();
-				return true;
+			CopLockOpScope opScope(CopLockOp::Get);
+			TierPtr tier;
+			CopRemovalBatch<Key, Value> removed;
+			{
+				std::lock_guard<LockPolicy> lock(mutex_);
+				auto it = nodeMap_.find(key);
+				if (it != nodeMap_.end() && !isStale(it->second)) {
+					moveToMostRecent(it->second);
+					//üжӦڵ㣬ôõvalue޸ΪӦڵֵ
+					value = it->second->getValue();
+					return true;
+				}
+				//ʧЧΪδ,˳
+				if (it != nodeMap_.end())
+					expireNode(it->second);
+				tier = victimTier_;
+				removed = removals_.drain();
 			}
-			//򷵻false
-			return false;
+			removed.deliver();
+			//ڴδʱٲļ,ڴ;򷵻false
+			return tier && tier->take(key, value) && promote(key, value);
 		}
 
 		//getĺ
@@ -115,21 +164,231 @@ namespace CopCache {
 
 		void remove(Key key) {
 
-			std::lock_guard<std::mutex> lock(mutex_);
+			CopRemovalBatch<Key, Value> removed;
+			{
+				std::lock_guard<LockPolicy> lock(mutex_);
+				auto it = nodeMap_.find(key);
+				if (it != nodeMap_.end()) {
+					removals_.push(key, it->second->getValue(), CopRemovalCause::Explicit);
+					removeNode(it->second);
+					nodeMap_.erase(it);
+				}
+				//ļпܻоֵ,һɾ
+				if (victimTier_)
+					victimTier_->erase(key);
+				removed = removals_.drain();
+			}
+			removed.deliver();
+		}
+
+		//ԭӶд:ȡصдһμһβ(CopCompute.h)
+		//صִ,ٷʱ;ڴûʱȴļȡ,еļԭǩ
+		template <typename Fn>
+		bool compute(Key key, Fn fn)
+		{
+			CopLockOpScope opScope(CopLockOp::Put);
+			bool present = false;
+			CopRemovalBatch<Key, Value> removed;
+			{
+				std::lock_guard<LockPolicy> lock(mutex_);
+				if (capacity_ <= 0)
+					return false;
+				auto it = nodeMap_.find(key);
+				if (it != nodeMap_.end() && isStale(it->second)) {
+					expireNode(it->second);
+					it = nodeMap_.end();
+				}
+				Value value{};
+				if (it == nodeMap_.end() && victimTier_ && victimTier_->take(key, value)) {
+					addNewNode(key, value);
+					it = nodeMap_.find(key);
+				}
+				bool found = it != nodeMap_.end();
+				if (found)
+					value = it->second->getValue();
+
+				CopComputeAction action = fn(value, found);
+				if (action == CopComputeAction::Store) {
+					if (found)
+						updateExistingNode(it->second, value, it->second->tag_);
+					else
+						addNewNode(key, value);
+					present = true;
+				}
+				else if (action == CopComputeAction::Remove) {
+					if (found) {
+						removals_.push(key, it->second->getValue(), CopRemovalCause::Explicit);
+						removeNode(it->second);
+						nodeMap_.erase(it);
+					}
+					if (victimTier_)
+						victimTier_->erase(key);
+				}
+				else {
+					if (found)
+						moveToMostRecent(it->second);
+					present = found;
+				}
+				removed = removals_.drain();
+			}
+			removed.deliver();
+			return present;
+		}
+
+		//ֻ:˳,д¿Բִ
+		bool contains(Key key)
+		{
+			std::shared_lock<LockPolicy> lock(mutex_);
 			auto it = nodeMap_.find(key);
-			if (it != nodeMap_.end()) {
-				removeNode(it->second);
-				nodeMap_.erase(it);
+			return it != nodeMap_.end() && !isStale(it->second);
+		}
+
+		bool peek(Key key, Value& value)
+		{
+			std::shared_lock<LockPolicy> lock(mutex_);
+			auto it = nodeMap_.find(key);
+			if (it == nodeMap_.end() || isStale(it->second))
+				return false;
+			value = it->second->getValue();
+			return true;
+		}
+
+		//O(1)ʹȫʧЧ,ڽڵڷʡ̭sweepStaleʱ
+		void invalidateAll()
+		{
+			std::lock_guard<LockPolicy> lock(mutex_);
+			generations_.invalidateAll();
+			if (victimTier_)
+				victimTier_->clear();
+		}
+
+		//O(1)ʹĳǩµȫʧЧ
+		void invalidateTag(CopTag tag)
+		{
+			std::lock_guard<LockPolicy> lock(mutex_);
+			generations_.invalidateTag(tag);
+		}
+
+		//ɨ:ϴͣµλmaxStepsڵ,йڵ,ػ
+		size_t sweepStale(size_t maxSteps = CopResizeStep)
+		{
+			size_t reclaimed = 0;
+			CopRemovalBatch<Key, Value> removed;
+			{
+				std::lock_guard<LockPolicy> lock(mutex_);
+				if (!generations_.hasInvalidations())
+					return 0;
+				for (size_t i = 0; i < maxSteps && !nodeMap_.empty(); ++i) {
+					if (!sweepCursor_ || sweepCursor_ == dummyTail_)
+						sweepCursor_ = dummyHead_->next_;
+					NodePtr node = sweepCursor_;
+					sweepCursor_ = node->next_;
+					if (isStale(node)) {
+						expireNode(node);
+						++reclaimed;
+					}
+				}
+				removed = removals_.drain();
+			}
+			removed.deliver();
+			return reclaimed;
+		}
+
+		//ߵ;ʱCopResizeStep̭δʵĽڵ,ͷ
+		void setCapacity(size_t capacity)
+		{
+			{
+				std::lock_guard<LockPolicy> lock(mutex_);
+				capacity_ = static_cast<int>(capacity);
 			}
+			evictDownTo(capacity);
+		}
+
+		//̨άģʽ:put೬slackڵ̭,maintainǰ̭;0Ϊر(Ĭ)
+		void setMaintenanceSlack(size_t slack)
+		{
+			std::lock_guard<LockPolicy> lock(mutex_);
+			slack_ = slack;
+		}
+
+		//̨ά:ˮλ(ȥһ)̭ʧЧڵ,شĽڵ
+		//̭ͻÿָദmaxStepsڵ,ûһ
+		//CopMaintenanceScheduler÷ĺ̨߳ڵ
+		size_t maintain(size_t maxSteps = CopResizeStep)
+		{
+			size_t lowWater;
+			{
+				std::lock_guard<LockPolicy> lock(mutex_);
+				size_t capacity = static_cast<size_t>(std::max(capacity_, 0));
+				lowWater = capacity - std::min(capacity, slack_ / 2);
+			}
+			return evictDownTo(lowWater, maxSteps) + sweepStale(maxSteps);
+		}
+
+		size_t capacity()
+		{
+			std::shared_lock<LockPolicy> lock(mutex_);
+			return capacity_;
+		}
+
+		size_t size()
+		{
+			std::shared_lock<LockPolicy> lock(mutex_);
+			return nodeMap_.size();
+		}
+
+		//ͳ,LockPolicyΪCopProfiledLockҶCOP_LOCK_PROFILINGʱ
+		CopLockStats lockStats() const
+		{
+			return copLockStats(mutex_);
+		}
+
+		//öļ,̭Ľڵдò
+		void setVictimTier(TierPtr tier)
+		{
+			std::lock_guard<LockPolicy> lock(mutex_);
+			victimTier_ = tier;
+		}
+
+		//Ƴ,̭/ɾ/ǵĽڵ֪ͨ
+		void setRemovalListener(ListenerPtr listener)
+		{
+			std::lock_guard<LockPolicy> lock(mutex_);
+			removals_.setListener(listener);
 		}
 	private:
 		int    capacity_;//
 		NodeMap nodeMap_;// ڵϣ
-		std::mutex mutex_;
+		LockPolicy mutex_;//,ģ
+		TierPtr victimTier_;//ļ,Ϊ
+		CopRemovalQueue<Key, Value> removals_;//ڼܵƳ֪ͨ
 		NodePtr dummyHead_;
 		NodePtr dummyTail_;//ڱͷβڵ
+		CopGenerations generations_;//ʧЧ
+		NodePtr sweepCursor_;//ɨĵǰλ
+		size_t slack_ = 0;//̨άģʽĽڵ
 
 	private:
+		//CopResizeStep̭targetڵ,̭maxSteps,ͷ,̭
+		size_t evictDownTo(size_t target, size_t maxSteps = SIZE_MAX)
+		{
+			size_t evicted = 0;
+			bool done = false;
+			while (!done)
+			{
+				CopRemovalBatch<Key, Value> removed;
+				{
+					std::lock_guard<LockPolicy> lock(mutex_);
+					for (size_t i = 0; i < CopResizeStep && evicted < maxSteps && nodeMap_.size() > target; ++i, ++evicted)
+						evictLeastRecent();
+					done = nodeMap_.size() <= target || evicted >= maxSteps;
+					removed = removals_.drain();
+				}
+				removed.deliver();
+			}
+			return evicted;
+		}
+
 		//ʼ
 		void initializeList() {
 			//ͷβڱڵ㣬ʼֵΪ
@@ -141,24 +400,52 @@ namespace CopCache {
 		}
 
 		//´ڻеĽڵֵ
-		void updateExistingNode(NodePtr node, const Value& value)
+		void updateExistingNode(NodePtr node, const Value& value, CopTag tag)
 		{
+			removals_.push(node->getKey(), node->getValue(), CopRemovalCause::Replaced);
 			node->setValue(value);
+			node->stamp_ = generations_.stamp();
+			node->tag_ = tag;
 			moveToMostRecent(node);//ִвҪڵƶλ
 		}
 
 		//½ڵ
-		void addNewNode(const Key& key, const Value& value)
+		void addNewNode(const Key& key, const Value& value, CopTag tag = 0)
 		{
-			if (nodeMap_.size() >= capacity_) {
+			//̨άģʽֻڳʱž͵̭,֤Ͻ
+			if (nodeMap_.size() >= static_cast<size_t>(capacity_) + slack_) {
 				evictLeastRecent();
 			}//ڴٷ
 
 			NodePtr newNode = std::make_shared<LruNodeType>(key, value);
+			newNode->stamp_ = generations_.stamp();
+			newNode->tag_ = tag;
 			insertNode(newNode);
 			nodeMap_[key] = newNode;
 		}
 
+		//ļڴ,ڼѱдڴеֵΪ׼
+		bool promote(const Key& key, Value& value)
+		{
+			CopRemovalBatch<Key, Value> removed;
+			{
+				std::lock_guard<LockPolicy> lock(mutex_);
+				auto it = nodeMap_.find(key);
+				if (it != nodeMap_.end() && !isStale(it->second)) {
+					moveToMostRecent(it->second);
+					value = it->second->getValue();
+				}
+				else {
+					if (it != nodeMap_.end())
+						expireNode(it->second);
+					addNewNode(key, value);
+				}
+				removed = removals_.drain();
+			}
+			removed.deliver();
+			return true;
+		}
+
 		//ýڵƶλ
 		void moveToMostRecent(NodePtr node) {
 			removeNode(node);
@@ -167,6 +454,9 @@ namespace CopCache {
 
 		//Ƴڵ
 		void removeNode(NodePtr node) {
+			//ɨλڱߵĽڵʱ˳ӵһ
+			if (node == sweepCursor_)
+				sweepCursor_ = node->next_;
 			node->prev_->next_ = node->next_;
 			node->next_->prev_ = node->prev_;
 		}
@@ -181,9 +471,29 @@ namespace CopCache {
 
 		//ٷ
 		void evictLeastRecent() {
+			copLockNote(CopLockOp::Evict);
 			NodePtr leastRecent = dummyHead_->next_;
 			removeNode(leastRecent);
 			nodeMap_.erase(leastRecent->getKey());//ӹϣƳӦ
+			bool stale = isStale(leastRecent);
+			removals_.push(leastRecent->getKey(), leastRecent->getValue(),
+				stale ? CopRemovalCause::Expired : CopRemovalCause::Capacity);
+			//ļʱ,̭Ľڵ³ļ;ļ㲻¼ǩ,ǩѹڵĽڵֱӶ
+			if (victimTier_ && !stale && leastRecent->tag_ == 0)
+				victimTier_->store(leastRecent->getKey(), leastRecent->getValue());
+		}
+
+		bool isStale(const NodePtr& node) const
+		{
+			return generations_.isStale(node->stamp_, node->tag_);
+		}
+
+		//һڽڵ
+		void expireNode(NodePtr node)
+		{
+			removeNode(node);
+			nodeMap_.erase(node->getKey());
+			removals_.push(node->getKey(), node->getValue(), CopRemovalCause::Expired);
 		}
 
 
@@ -191,15 +501,15 @@ namespace CopCache {
 	}; 
 
 	//LRUŻLRU-k汾̳Lru,עģ壬ģ廯
-	template <typename Key,typename Value>
-	class CopLruKCache : public CopLruCache <Key, Value>
+	template <typename Key,typename Value,typename LockPolicy = CopMutexLock>
+	class CopLruKCache : public CopLruCache <Key, Value, LockPolicy>
 	{
 	public:
 		//캯
 		CopLruKCache(int capacity,int historyCapacity,int k)
-			:CopLruCache<Key,Value>(capacity)//ʹûʼڴ棬֤ڴһ
+			:CopLruCache<Key,Value,LockPolicy>(capacity)//ʹûʼڴ棬֤ڴһ
 			//CopLruCache󣬲ָָ󣬴ݷʶеҲѭLRU㷨
-			,historyList_(std::make_unique<CopLruCache<Key,size_t>>(historyCapacity))
+			,historyList_(std::make_unique<CopLruCache<Key,size_t,LockPolicy>>(historyCapacity))
 			,k_(k)
 		{}
 
@@ -211,14 +521,14 @@ namespace CopCache {
 			historyList_->put(key, ++historyCount);
 
 			//ȡеĶӦֵڻеĻעʹlruеget
-			return CopLruCache<Key, Value> ::get(key);
+			return CopLruCache<Key, Value, LockPolicy> ::get(key);
 
 		}
 
 		void put(Key key,Value value) {
 			//ڻдڣֱӸֵ
-			if (CopLruCache<Key, Value>::get(key) != "") {
-				CopLruCache<Key, Value>::put(key, value);
+			if (CopLruCache<Key, Value, LockPolicy>::get(key) != "") {
+				CopLruCache<Key, Value, LockPolicy>::put(key, value);
 			}
 
 			//ڣӵݷʶУӴ
@@ -230,61 +540,377 @@ namespace CopCache {
 				//Ƴʷʼ¼
 				historyList_->remove(key);
 				//Lruputӽ
-				CopLruCache<Key, Value>::put(key, value);
+				CopLruCache<Key, Value, LockPolicy>::put(key, value);
 			}
 		}
 
 
 	private:
 		int k_;//ʷ¼뻺еı׼
-		std::unique_ptr<CopLruCache<Key, size_t>> historyList_;//ʷ¼УֵӦڵķʴӳ
+		std::unique_ptr<CopLruCache<Key, size_t, LockPolicy>> historyList_;//ʷ¼УֵӦڵķʴӳ
 	};
 
-	//lruϣŻ,߸߲ʹõ
-	template<typename Key,typename Value>
-	class CopHashLruCache
+	//LRUŻ:ֶLRU(SLRU)Ƚö,öٴвŽ
+	//ʱɵݽöͷ,̭ȷöβ,
+	//һ˳ɨֻˢö,ȵݲӰ졣вO(1)
+	template <typename Key, typename Value, typename LockPolicy = CopMutexLock>
+	class CopSlruCache : public CopCachePolicy<Key, Value>,
+		public CopComputeOps<CopSlruCache<Key, Value, LockPolicy>, Key, Value>
 	{
 	public:
-		CopHashLruCache(size_t capacity, int sliceNum) :
-			capacity_(capacity),
-			sliceNum_(sliceNum > 0 ? sliceNum : std::thread::hardware_concurrency())//ƬͳʼƬʹĬֵ
+		using TierPtr = std::shared_ptr<CopFileTier<Key, Value>>;
+		using ListenerPtr = std::shared_ptr<CopEvictionListener<Key, Value>>;
+
+		//protectedRatioΪռı
+		CopSlruCache(int capacity, double protectedRatio = 0.8)
+			:capacity_(capacity > 0 ? capacity : 0)
+			, protectedRatio_(std::min(std::max(protectedRatio, 0.0), 1.0))
 		{
-			size_t sliceSize = std::ceil(capacity / static_cast<double> (sliceNum_));//ȡÿһƬĴС,ȡ
-			for (int i = 0; i < sliceNum_; i++) {
-				lruSliceCaches_.emplace_back(new CopLruCache<Key, Value>(sliceSize));//ƬһСlruӵ
-			}
+			updateProtectedCapacity();
 		}
 
-		void put(Key key, Value value) {
-			//ȡKeyhashֵƬ
-			size_t sliceIndex = Hash(key) % sliceNum_;
-			//ȻöӦֵȥȡӦָ룬Ӷøûput޸ĻнڵĶӦֵ
-			return lruSliceCaches_[sliceIndex]->put(key, value);
+		~CopSlruCache() override = default;
+
+		void put(Key key, Value value) override
+		{
+			CopLockOpScope opScope(CopLockOp::Put);
+			CopRemovalBatch<Key, Value> removed;
+			{
+				std::lock_guard<LockPolicy> lock(mutex_);
+				if (capacity_ == 0)
+					return;
+				auto it = entryMap_.find(key);
+				if (it != entryMap_.end()) {
+					removals_.push(key, it->second.iter->value, CopRemovalCause::Replaced);
+					it->second.iter->value = value;
+					touch(it->second);
+				}
+				else {
+					insertProbation(key, value);
+				}
+				//ļľɸѹʱ
+				if (victimTier_)
+					victimTier_->erase(key);
+				removed = removals_.drain();
+			}
+			removed.deliver();
 		}
-		
-		//жϻǷkeyӦĽڵ,valueΪ
-		bool get(Key key,Value value) {
-			size_t sliceIndex = Hash(key) % sliceNum_;
-			return lruSliceCaches_[sliceIndex]->get(key, value);
+
+		bool get(Key key, Value& value) override
+		{
+			CopLockOpScope opScope(CopLockOp::Get);
+			TierPtr tier;
+			{
+				std::lock_guard<LockPolicy> lock(mutex_);
+				auto it = entryMap_.find(key);
+				if (it != entryMap_.end()) {
+					touch(it->second);
+					value = it->second.iter->value;
+					return true;
+				}
+				tier = victimTier_;
+			}
+			//ڴδʱļ,кŻö
+			return tier && tier->take(key, value) && promote(key, value);
 		}
 
-		Value get(Key key) {
-			Value value;
-			memset(&value, 0, sizeof(value));//ʼֵںץȡӦֵ
+		Value get(Key key) override
+		{
+			Value value{};
 			get(key, value);
-			return value;//ûнڵͻ᷵سʼֵ
+			return value;
+		}
+
+		void remove(Key key)
+		{
+			CopRemovalBatch<Key, Value> removed;
+			{
+				std::lock_guard<LockPolicy> lock(mutex_);
+				auto it = entryMap_.find(key);
+				if (it != entryMap_.end()) {
+					removals_.push(key, it->second.iter->value, CopRemovalCause::Explicit);
+					(it->second.inProtected ? protected_ : probation_).erase(it->second.iter);
+					entryMap_.erase(it);
+				}
+				if (victimTier_)
+					victimTier_->erase(key);
+				removed = removals_.drain();
+			}
+			removed.deliver();
+		}
+
+		//ԭӶд,ͬCopLruCache::compute
+		template <typename Fn>
+		bool compute(Key key, Fn fn)
+		{
+			CopLockOpScope opScope(CopLockOp::Put);
+			bool present = false;
+			CopRemovalBatch<Key, Value> removed;
+			{
+				std::lock_guard<LockPolicy> lock(mutex_);
+				if (capacity_ == 0)
+					return false;
+				auto it = entryMap_.find(key);
+				Value value{};
+				if (it == entryMap_.end() && victimTier_ && victimTier_->take(key, value)) {
+					insertProbation(key, value);
+					it = entryMap_.find(key);
+				}
+				bool found = it != entryMap_.end();
+				if (found)
+					value = it->second.iter->value;
+
+				CopComputeAction action = fn(value, found);
+				if (action == CopComputeAction::Store) {
+					if (found) {
+						removals_.push(key, it->second.iter->value, CopRemovalCause::Replaced);
+						it->second.iter->value = value;
+						touch(it->second);
+					}
+					else {
+						insertProbation(key, value);
+					}
+					present = true;
+				}
+				else if (action == CopComputeAction::Remove) {
+					if (found) {
+						removals_.push(key, it->second.iter->value, CopRemovalCause::Explicit);
+						(it->second.inProtected ? protected_ : probation_).erase(it->second.iter);
+						entryMap_.erase(it);
+					}
+					if (victimTier_)
+						victimTier_->erase(key);
+				}
+				else {
+					if (found)
+						touch(it->second);
+					present = found;
+				}
+				removed = removals_.drain();
+			}
+			removed.deliver();
+			return present;
+		}
+
+		//ֻ:Ҳ˳
+		bool contains(Key key)
+		{
+			std::shared_lock<LockPolicy> lock(mutex_);
+			return entryMap_.find(key) != entryMap_.end();
+		}
+
+		bool peek(Key key, Value& value)
+		{
+			std::shared_lock<LockPolicy> lock(mutex_);
+			auto it = entryMap_.find(key);
+			if (it == entryMap_.end())
+				return false;
+			value = it->second.iter->value;
+			return true;
+		}
+
+		//ߵ,ΰԭ»;ʱCopResizeStep̭
+		void setCapacity(size_t capacity)
+		{
+			{
+				std::lock_guard<LockPolicy> lock(mutex_);
+				capacity_ = capacity;
+				updateProtectedCapacity();
+				demoteOverflow();
+			}
+			evictDownTo(capacity);
+		}
+
+		//̨άģʽ,ͬCopLruCache::setMaintenanceSlack
+		void setMaintenanceSlack(size_t slack)
+		{
+			std::lock_guard<LockPolicy> lock(mutex_);
+			slack_ = slack;
+		}
+
+		//̨ά:ˮλ̭,ÿ̭maxSteps,̭
+		size_t maintain(size_t maxSteps = CopResizeStep)
+		{
+			size_t lowWater;
+			{
+				std::lock_guard<LockPolicy> lock(mutex_);
+				lowWater = capacity_ - std::min(capacity_, slack_ / 2);
+			}
+			return evictDownTo(lowWater, maxSteps);
+		}
+
+		size_t capacity()
+		{
+			std::shared_lock<LockPolicy> lock(mutex_);
+			return capacity_;
+		}
+
+		size_t size()
+		{
+			std::shared_lock<LockPolicy> lock(mutex_);
+			return entryMap_.size();
+		}
+
+		CopLockStats lockStats() const
+		{
+			return copLockStats(mutex_);
+		}
+
+		//εǰ,ڹ۲ɨȵӰ
+		size_t protectedSize()
+		{
+			std::shared_lock<LockPolicy> lock(mutex_);
+			return protected_.size();
+		}
+
+		void setVictimTier(TierPtr tier)
+		{
+			std::lock_guard<LockPolicy> lock(mutex_);
+			victimTier_ = tier;
+		}
+
+		void setRemovalListener(ListenerPtr listener)
+		{
+			std::lock_guard<LockPolicy> lock(mutex_);
+			removals_.setListener(listener);
 		}
+
 	private:
-		//keyתɶӦhashֵ
-		size_t Hash(Key key) {
-			std::hash<Key> hashFunc;
-			return hashFunc(key);
+		struct Entry
+		{
+			Key key;
+			Value value;
+		};
+		using EntryList = std::list<Entry>;
+
+		struct Location
+		{
+			typename EntryList::iterator iter;
+			bool inProtected;
+		};
+
+		//ٸöһλ,֤ܽ
+		void updateProtectedCapacity()
+		{
+			protectedCapacity_ = static_cast<size_t>(capacity_ * protectedRatio_);
+			if (capacity_ > 0 && protectedCapacity_ >= capacity_)
+				protectedCapacity_ = capacity_ - 1;
+		}
+
+		//:öεݽ,εƵͷ
+		void touch(Location& location)
+		{
+			if (location.inProtected) {
+				protected_.splice(protected_.begin(), protected_, location.iter);
+				return;
+			}
+			protected_.splice(protected_.begin(), probation_, location.iter);
+			location.inProtected = true;
+			demoteOverflow();
+		}
+
+		//γʱ,ɵݽöͷ
+		void demoteOverflow()
+		{
+			while (protected_.size() > protectedCapacity_) {
+				auto oldest = std::prev(protected_.end());
+				entryMap_[oldest->key].inProtected = false;
+				probation_.splice(probation_.begin(), protected_, oldest);
+			}
+		}
+
+		void insertProbation(const Key& key, const Value& value)
+		{
+			if (entryMap_.size() >= capacity_ + slack_)
+				evictOne();
+			probation_.push_front({ key, value });
+			entryMap_[key] = { probation_.begin(), false };
+		}
+
+		size_t evictDownTo(size_t target, size_t maxSteps = SIZE_MAX)
+		{
+			size_t evicted = 0;
+			bool done = false;
+			while (!done)
+			{
+				CopRemovalBatch<Key, Value> removed;
+				{
+					std::lock_guard<LockPolicy> lock(mutex_);
+					for (size_t i = 0; i < CopResizeStep && evicted < maxSteps && entryMap_.size() > target; ++i, ++evicted)
+						evictOne();
+					done = entryMap_.size() <= target || evicted >= maxSteps;
+					removed = removals_.drain();
+				}
+				removed.deliver();
+			}
+			return evicted;
+		}
+
+		//̭öβ,öΪʱŶ
+		void evictOne()
+		{
+			EntryList& list = probation_.empty() ? protected_ : probation_;
+			if (list.empty())
+				return;
+			copLockNote(CopLockOp::Evict);
+			Entry& victim = list.back();
+			removals_.push(victim.key, victim.value, CopRemovalCause::Capacity);
+			if (victimTier_)
+				victimTier_->store(victim.key, victim.value);
+			entryMap_.erase(victim.key);
+			list.pop_back();
+		}
+
+		bool promote(const Key& key, Value& value)
+		{
+			CopRemovalBatch<Key, Value> removed;
+			{
+				std::lock_guard<LockPolicy> lock(mutex_);
+				auto it = entryMap_.find(key);
+				if (it != entryMap_.end()) {
+					touch(it->second);
+					value = it->second.iter->value;
+				}
+				else {
+					insertProbation(key, value);
+				}
+				removed = removals_.drain();
+			}
+			removed.deliver();
+			return true;
 		}
 
 	private:
 		size_t capacity_;//
-		int sliceNum_;//Ƭ
-		std::vector<std::unique_ptr<CopLruCache<Key, Value>>> lruSliceCaches_;//ƬLRU
+		size_t protectedCapacity_;//
+		double protectedRatio_;//ռ
+		LockPolicy mutex_;//,ģ
+		EntryList probation_;//ö,ͷ
+		EntryList protected_;//,ͷ
+		typename CopKeyTraits<Key>::template MapType<Location> entryMap_;
+		TierPtr victimTier_;//ļ,Ϊ
+		CopRemovalQueue<Key, Value> removals_;//ڼܵƳ֪ͨ
+		size_t slack_ = 0;//̨άģʽ
+	};
+
+	//ֶLRUķƬ汾,protectedRatioÿƬ
+	template<typename Key, typename Value, typename LockPolicy = CopMutexLock>
+	class CopHashSlruCache : public CopShardedCache<Key, Value, CopSlruCache<Key, Value, LockPolicy>>
+	{
+	public:
+		CopHashSlruCache(size_t capacity, int sliceNum, double protectedRatio = 0.8)
+			:CopShardedCache<Key, Value, CopSlruCache<Key, Value, LockPolicy>>(capacity, sliceNum, protectedRatio)
+		{}
+	};
+
+	//lruϣŻ,߸߲ʹõ
+	template<typename Key,typename Value,typename LockPolicy = CopMutexLock>
+	class CopHashLruCache : public CopShardedCache<Key, Value, CopLruCache<Key, Value, LockPolicy>>
+	{
+	public:
+		CopHashLruCache(size_t capacity, int sliceNum)
+			:CopShardedCache<Key, Value, CopLruCache<Key, Value, LockPolicy>>(capacity, sliceNum)
+		{}
 	};
 
 
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace CopCache {
+
+	//̨ά߳:̶ִеǼǵά,̭ƵϻʧЧڵƳǰ̨·
+	//ϻsetMaintenanceSlackʹ:putֻO(1),Ĳ(slack)
+	//ڵmaintainˮλ̭,ÿÿƬ̭CopResizeStep;
+	//þʱputԻ͵̭,֤Ͻ
+	//άִ߳,Ҫб֤̰߳ȫ(LRU/LFU/SLRUƬ汾maintainѼ)
+	class CopMaintenanceScheduler
+	{
+	public:
+		explicit CopMaintenanceScheduler(std::chrono::milliseconds interval)
+			:interval_(interval)
+			, stop_(false)
+		{
+			thread_ = std::thread(&CopMaintenanceScheduler::loop, this);
+		}
+
+		~CopMaintenanceScheduler()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				stop_ = true;
+			}
+			cv_.notify_one();
+			thread_.join();
+		}
+
+		CopMaintenanceScheduler(const CopMaintenanceScheduler&) = delete;
+		CopMaintenanceScheduler& operator=(const CopMaintenanceScheduler&) = delete;
+
+		//Ǽά
+		void add(std::function<void()> task)
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			tasks_.push_back(std::move(task));
+		}
+
+		//Ǽһ,ÿֵmaintain;Ҫȵø
+		template <typename Cache>
+		void add(Cache& cache)
+		{
+			add([&cache] { cache.maintain(); });
+		}
+
+		//άִ߳һ,ȴ
+		void wakeup()
+		{
+			cv_.notify_one();
+		}
+
+		//ڵִ߳ͬһ,ڲԻɵ÷
+		void runOnce()
+		{
+			std::lock_guard<std::mutex> runLock(runMutex_);
+			std::vector<std::function<void()>> tasks;
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				tasks = tasks_;
+			}
+			for (auto& task : tasks)
+				task();
+		}
+
+	private:
+		void loop()
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			while (!stop_)
+			{
+				cv_.wait_for(lock, interval_);
+				if (stop_)
+					break;
+				lock.unlock();
+				runOnce();
+				lock.lock();
+			}
+		}
+
+	private:
+		std::chrono::milliseconds interval_;//ά
+		std::vector<std::function<void()>> tasks_;
+		bool stop_;
+		std::mutex mutex_;//ֹͣ
+		std::mutex runMutex_;//лά
+		std::condition_variable cv_;
+		std::thread thread_;
+	};
+
+}// coloop
@@ -0,0 +1,235 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+namespace CopCache {
+
+	//һڴ;ȡʧܵΪ0
+	struct CopMemorySample
+	{
+		uint64_t rssBytes = 0;//̳פڴ,/proc/self/statm
+		uint64_t cgroupCurrent = 0;//cgroup v2 memory.current
+		uint64_t cgroupMax = 0;//cgroup v2 memory.max,Ϊ"max"ʱΪ0
+		double pressureAvg10 = 0.0;//memory.pressuresome avg10,10ڴʱٷֱ
+	};
+
+	///proc/self/cgroupڵcgroup v2Ŀ¼(0::<·>һ),cgroup v2ʱؿ
+	inline std::string copSelfCgroupDir()
+	{
+		std::ifstream cgroup("/proc/self/cgroup");
+		std::string line;
+		while (std::getline(cgroup, line))
+		{
+			if (line.compare(0, 3, "0::") != 0)
+				continue;
+			std::string path = line.substr(3);
+			if (path.empty() || path == "/")
+				return "/sys/fs/cgroup";
+			return "/sys/fs/cgroup" + path;
+		}
+		return std::string();
+	}
+
+	//ȡǰ̵ڴ;cgroupDirΪʱֻRSS
+	inline CopMemorySample copReadMemorySample(const std::string& cgroupDir)
+	{
+		CopMemorySample sample;
+		{
+			std::ifstream statm("/proc/self/statm");
+			uint64_t totalPages = 0;
+			uint64_t residentPages = 0;
+			if (statm >> totalPages >> residentPages)
+				sample.rssBytes = residentPages * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+		}
+		if (cgroupDir.empty())
+			return sample;
+		{
+			std::ifstream current(cgroupDir + "/memory.current");
+			current >> sample.cgroupCurrent;
+		}
+		{
+			std::ifstream max(cgroupDir + "/memory.max");
+			std::string text;
+			if (max >> text && text != "max")
+				sample.cgroupMax = std::strtoull(text.c_str(), nullptr, 10);
+		}
+		{
+			//ʽ:some avg10=0.12 avg60=0.05 avg300=0.01 total=12345
+			std::ifstream pressure(cgroupDir + "/memory.pressure");
+			std::string line;
+			while (std::getline(pressure, line))
+			{
+				if (line.compare(0, 5, "some ") != 0)
+					continue;
+				size_t pos = line.find("avg10=");
+				if (pos != std::string::npos)
+					sample.pressureAvg10 = std::strtod(line.c_str() + pos + 6, nullptr);
+				break;
+			}
+		}
+		return sample;
+	}
+
+	struct CopMemoryGovernorConfig
+	{
+		uint64_t limitBytes = 0;//ڴ,0ʾʹcgroupmemory.max;߶ûʱֻѹָ
+		double highWater = 0.90;//޵Ϊѹ,ʼ
+		double lowWater = 0.75;//ûѹʱ𲽻ָ
+		double pressureThreshold = 10.0;//memory.pressure some avg10ֵҲΪѹ
+		double shrinkStep = 0.10;//ÿǰı
+		double growStep = 0.05;//ÿλָԭʼı
+		double minScale = 0.25;//ԭʼı
+		std::string cgroupDir = copSelfCgroupDir();//cgroup v2Ŀ¼,ĬΪڵcgroup,Ϊ򲻶cgroup
+	};
+
+	namespace detail {
+
+		//СĲ(ṩusedSize,GDSF)λɵ÷,Ǽʱÿλֽ
+		template <typename Cache, typename = void>
+		struct CopSizeWeighted : std::false_type {};
+
+		template <typename Cache>
+		struct CopSizeWeighted<Cache, decltype(std::declval<Cache&>().usedSize(), void())> : std::true_type {};
+
+	}
+
+	//ڴѹ:ԲRSScgroupڴ,ѹʱǼǵĻ,
+	//ѹʧ𲽻ָԭʼ;ƬsetCapacityƬռ̯,Ȼ̯ÿƬ
+	//ܹ㻺ռֽʱ,һķصˮλ,shrinkStep
+	//߳,ɵ÷CopMaintenanceSchedulerڵpoll
+	class CopMemoryGovernor
+	{
+	public:
+		explicit CopMemoryGovernor(CopMemoryGovernorConfig config = CopMemoryGovernorConfig())
+			:config_(std::move(config))
+			, scale_(1.0)
+		{}
+
+		CopMemoryGovernor(const CopMemoryGovernor&) = delete;
+		CopMemoryGovernor& operator=(const CopMemoryGovernor&) = delete;
+
+		//Ǽһ֧capacity/setCapacityĻ,ԵǰΪԭʼ;Ҫȵø
+		//֪ÿλռöֽ,ֻܰshrinkStep;СĻ治
+		template <typename Cache>
+		void add(Cache& cache)
+		{
+			static_assert(!detail::CopSizeWeighted<Cache>::value,
+				"CopMemoryGovernor::add: size-weighted caches need an explicit bytesPerUnit");
+			add(cache, 0);
+		}
+
+		//bytesPerUnitΪÿλԼռõֽ(ĿʱΪС,GDSFΪСλӦֽ),0ʾδ֪
+		template <typename Cache>
+		void add(Cache& cache, uint64_t bytesPerUnit)
+		{
+			Target target;
+			target.baseCapacity = cache.capacity();
+			target.bytesPerUnit = bytesPerUnit;
+			target.setCapacity = [&cache](size_t capacity) { cache.setCapacity(capacity); };
+			std::lock_guard<std::mutex> lock(mutex_);
+			target.setCapacity(scaled(target.baseCapacity));
+			targets_.push_back(std::move(target));
+		}
+
+		//һβ,Ƿ仯
+		bool poll()
+		{
+			return apply(copReadMemorySample(config_.cgroupDir));
+		}
+
+		//,ڲԻڴԴ
+		bool apply(const CopMemorySample& sample)
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			last_ = sample;
+			double usage = usageRatio(sample);
+			bool pressure = usage > config_.highWater || sample.pressureAvg10 > config_.pressureThreshold;
+			double scale = scale_;
+			if (pressure)
+			{
+				double step = config_.shrinkStep;
+				//ܹ㻺ռʱ,һóԻصˮλ
+				uint64_t limit = limitBytes(sample);
+				uint64_t cacheBytes = 0;
+				for (const auto& target : targets_)
+					cacheBytes += static_cast<uint64_t>(scaled(target.baseCapacity)) * target.bytesPerUnit;
+				if (limit > 0 && cacheBytes > 0 && usage > config_.lowWater)
+				{
+					double excess = (usage - config_.lowWater) * static_cast<double>(limit);
+					step = std::max(step, excess / static_cast<double>(cacheBytes));
+				}
+				scale = std::max(config_.minScale, scale_ * (1.0 - std::min(step, 1.0)));
+			}
+			else if (usage < config_.lowWater)
+			{
+				scale = std::min(1.0, scale_ + config_.growStep);
+			}
+			if (scale == scale_)
+				return false;
+			scale_ = scale;
+			for (auto& target : targets_)
+				target.setCapacity(scaled(target.baseCapacity));
+			return true;
+		}
+
+		//ǰԭʼı
+		double scale()
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			return scale_;
+		}
+
+		CopMemorySample lastSample()
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			return last_;
+		}
+
+	private:
+		struct Target
+		{
+			size_t baseCapacity = 0;//Ǽʱԭʼ
+			uint64_t bytesPerUnit = 0;//ÿλֽ,0Ϊδ֪
+			std::function<void(size_t)> setCapacity;
+		};
+
+		size_t scaled(size_t capacity) const
+		{
+			return std::max<size_t>(1, static_cast<size_t>(capacity * scale_));
+		}
+
+		uint64_t limitBytes(const CopMemorySample& sample) const
+		{
+			return config_.limitBytes ? config_.limitBytes : sample.cgroupMax;
+		}
+
+		//̺cgroupиӽ޵Ǹ
+		double usageRatio(const CopMemorySample& sample) const
+		{
+			uint64_t limit = limitBytes(sample);
+			if (limit == 0)
+				return 0.0;
+			uint64_t used = std::max(sample.rssBytes, sample.cgroupCurrent);
+			return static_cast<double>(used) / static_cast<double>(limit);
+		}
+
+	private:
+		CopMemoryGovernorConfig config_;
+		double scale_;//ǰű
+		CopMemorySample last_;
+		std::vector<Target> targets_;
+		std::mutex mutex_;
+	};
+
+}// coloop
@@ -0,0 +1,233 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+#include "CopKeyTraits.h"
+
+namespace CopCache {
+
+	//:¼ȷϲڵļ,ÿֻռһ16λָ(Լ2ֽ),ڵ
+	//ò,ÿͰ4λ,ָֻܳѡͰ,֧ɾ
+	//TTLϻ:д,ÿдttl/2ɵһ,Ŀʱttl/2ttl֮
+	//ѯ,ֻԭӲλ;롢ɾͻһѻл
+	//ѯ"ܲ":ָͬͬĸԼΪ 8/65536,ֻĿ
+	template <typename Key>
+	class CopNegativeFilter
+	{
+	public:
+		//entriesΪһԤɵļ
+		CopNegativeFilter(size_t entries, std::chrono::milliseconds ttl)
+			:bucketMask_(bucketCountFor(entries) - 1)
+			, half_(std::max<int64_t>(1, std::chrono::duration_cast<std::chrono::nanoseconds>(ttl).count() / 2))
+			, current_(0)
+			, kickSeed_(0)
+		{
+			int64_t now = nowNs();
+			for (int g = 0; g < 2; ++g)
+			{
+				tables_[g].slots.reset(new std::atomic<uint16_t>[(bucketMask_ + 1) * kSlots]);
+				clearTable(tables_[g]);
+			}
+			//ڶʼΪ,ֻǰ趨ֹʱ
+			tables_[0].deadline.store(now + 2 * half_, std::memory_order_relaxed);
+			rotateAt_ = now + half_;
+		}
+
+		//Ϊδ
+		bool isKnownAbsent(const Key& key) const
+		{
+			uint64_t h = hashOf(key);
+			uint16_t fp = fingerprint(h);
+			size_t b1 = bucket1(h);
+			size_t b2 = altBucket(b1, fp);
+			int64_t now = nowNs();
+			for (const auto& table : tables_)
+			{
+				if (now >= table.deadline.load(std::memory_order_acquire))
+					continue;
+				if (inBucket(table, b1, fp) || inBucket(table, b2, fp))
+					return true;
+			}
+			return false;
+		}
+
+		void markAbsent(const Key& key)
+		{
+			uint64_t h = hashOf(key);
+			uint16_t fp = fingerprint(h);
+			size_t b1 = bucket1(h);
+			size_t b2 = altBucket(b1, fp);
+
+			std::lock_guard<std::mutex> lock(mutex_);
+			rotateIfDue();
+			Table& table = tables_[current_];
+			if (inBucket(table, b1, fp) || inBucket(table, b2, fp))
+				return;
+			if (tryPlace(table, b1, fp) || tryPlace(table, b2, fp))
+				return;
+
+			//ѡͰ:߳һָưᵽһѡͰ,kMaxKicks
+			//᲻ʱָ߳,Ըֻټһڵļ
+			size_t b = (++kickSeed_ & 1) ? b1 : b2;
+			for (int kick = 0; kick < kMaxKicks; ++kick)
+			{
+				std::atomic<uint16_t>& slot = table.slots[b * kSlots + (++kickSeed_ % kSlots)];
+				uint16_t victim = slot.load(std::memory_order_relaxed);
+				slot.store(fp, std::memory_order_release);
+				fp = victim;
+				b = altBucket(b, fp);
+				if (tryPlace(table, b, fp))
+					return;
+			}
+		}
+
+		//д뻺ɾĸ¼,Ҫɾ
+		void erase(const Key& key)
+		{
+			if (!isKnownAbsent(key))
+				return;
+			uint64_t h = hashOf(key);
+			uint16_t fp = fingerprint(h);
+			size_t b1 = bucket1(h);
+			size_t b2 = altBucket(b1, fp);
+
+			std::lock_guard<std::mutex> lock(mutex_);
+			for (auto& table : tables_)
+			{
+				removeFrom(table, b1, fp);
+				removeFrom(table, b2, fp);
+			}
+		}
+
+		void clear()
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			for (auto& table : tables_)
+			{
+				table.deadline.store(0, std::memory_order_release);
+				clearTable(table);
+			}
+			int64_t now = nowNs();
+			tables_[current_].deadline.store(now + 2 * half_, std::memory_order_release);
+			rotateAt_ = now + half_;
+		}
+
+	private:
+		static constexpr size_t kSlots = 4;//ÿͰĲλ
+		static constexpr int kMaxKicks = 128;
+
+		struct Table
+		{
+			std::unique_ptr<std::atomic<uint16_t>[]> slots;//0ʾղ
+			std::atomic<int64_t> deadline{ 0 };//дĿĹʱ
+		};
+
+		//Լ90%װʼͰ,ȡ2
+		static size_t bucketCountFor(size_t entries)
+		{
+			size_t need = std::max<size_t>(1, entries * 10 / 9 / kSlots + 1);
+			size_t count = 1;
+			while (count < need)
+				count <<= 1;
+			return count;
+		}
+
+		static int64_t nowNs()
+		{
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+
+		static uint64_t hashOf(const Key& key)
+		{
+			return static_cast<uint64_t>(CopKeyTraits<Key>::hash(key)) * 0x9E3779B97F4A7C15ULL;
+		}
+
+		//ָȡϣ16λ,0Ϊղ
+		static uint16_t fingerprint(uint64_t h)
+		{
+			uint16_t fp = static_cast<uint16_t>(h >> 48);
+			return fp != 0 ? fp : 1;
+		}
+
+		size_t bucket1(uint64_t h) const
+		{
+			return static_cast<size_t>(h) & bucketMask_;
+		}
+
+		//һѡͰֻɵǰͰָƾ,ᶯʱҪԭʼ
+		size_t altBucket(size_t b, uint16_t fp) const
+		{
+			return (b ^ static_cast<size_t>(fp * 0x5BD1E995u)) & bucketMask_;
+		}
+
+		static bool inBucket(const Table& table, size_t b, uint16_t fp)
+		{
+			for (size_t i = 0; i < kSlots; ++i)
+			{
+				if (table.slots[b * kSlots + i].load(std::memory_order_acquire) == fp)
+					return true;
+			}
+			return false;
+		}
+
+		static bool tryPlace(Table& table, size_t b, uint16_t fp)
+		{
+			for (size_t i = 0; i < kSlots; ++i)
+			{
+				std::atomic<uint16_t>& slot = table.slots[b * kSlots + i];
+				if (slot.load(std::memory_order_relaxed) == 0)
+				{
+					slot.store(fp, std::memory_order_release);
+					return true;
+				}
+			}
+			return false;
+		}
+
+		static void removeFrom(Table& table, size_t b, uint16_t fp)
+		{
+			for (size_t i = 0; i < kSlots; ++i)
+			{
+				std::atomic<uint16_t>& slot = table.slots[b * kSlots + i];
+				if (slot.load(std::memory_order_relaxed) == fp)
+					slot.store(0, std::memory_order_release);
+			}
+		}
+
+		void clearTable(Table& table)
+		{
+			for (size_t i = 0; i < (bucketMask_ + 1) * kSlots; ++i)
+				table.slots[i].store(0, std::memory_order_relaxed);
+		}
+
+		//ǰдttl/2󻻴:ɵһȱǹ,ѯյľ
+		void rotateIfDue()
+		{
+			int64_t now = nowNs();
+			if (now < rotateAt_)
+				return;
+			current_ ^= 1;
+			Table& table = tables_[current_];
+			table.deadline.store(0, std::memory_order_release);
+			clearTable(table);
+			table.deadline.store(now + 2 * half_, std::memory_order_release);
+			rotateAt_ = now + half_;
+		}
+
+	private:
+		size_t bucketMask_;
+		int64_t half_;//TTL,
+		Table tables_[2];
+		int current_;//дһ
+		int64_t rotateAt_;//´λʱ
+		size_t kickSeed_;
+		std::mutex mutex_;//л롢ɾͻ
+	};
+
+}// coloop
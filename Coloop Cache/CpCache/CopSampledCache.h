@@ -0,0 +1,355 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <utility>
+#include <vector>
+
+#include "CopCachePolicy.h"
+#include "CopEvictionListener.h"
+#include "CopKeyTraits.h"
+#include "CopLockPolicy.h"
+#include "CopLockProfiler.h"
+#include "CopShardedCache.h"
+
+namespace CopCache {
+
+	//̭ƵĲ
+	enum class CopSampledMode
+	{
+		Lru,//̭õ
+		Lfu//̭͵
+	};
+
+	//߳˽еxorshift,ֻڲ͸ʼ,Ҫ
+	inline uint32_t copFastRand()
+	{
+		thread_local uint32_t state = 0x9E3779B9u ^ static_cast<uint32_t>(reinterpret_cast<uintptr_t>(&state));
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return state;
+	}
+
+	//ĽLRU/LFU(Redisʽ̭):ݽյشλ,ÿλֻһ32λԪϢ
+	//	Lru:ʱ߼ʱ(ÿһ)
+	//	Lfu:24λΪϴ˥,8λΪ;ÿcapacityΪһ,ÿһڼ1
+	//ֻڹдһԪϢ,ƶκνڵ;LockPolicyΪCopSharedLockʱԲ
+	//̭ʱsamplesλ,αĺѡ(poolSize)ϲ̭һ,
+	//ѡѱʹĿ̭ǰ´,ɾձȵ
+	//ɾʱһλᵽλ,λʼ,ֻ[0,size)ȡ
+	template <typename Key, typename Value, CopSampledMode Mode = CopSampledMode::Lru, typename LockPolicy = CopMutexLock>
+	class CopSampledCache : public CopCachePolicy<Key, Value>
+	{
+	public:
+		using ListenerPtr = std::shared_ptr<CopEvictionListener<Key, Value>>;
+
+		explicit CopSampledCache(size_t capacity, int samples = 5, size_t poolSize = 16)
+			:capacity_(capacity)
+			, samples_(std::max(samples, 1))
+			, poolSize_(std::max<size_t>(poolSize, 1))
+			, clock_(0)
+			, meta_(capacity)
+		{
+			keys_.reserve(capacity);
+			values_.reserve(capacity);
+			pool_.reserve(poolSize_ + 1);
+		}
+
+		~CopSampledCache() override = default;
+
+		void put(Key key, Value value) override
+		{
+			CopLockOpScope opScope(CopLockOp::Put);
+			CopRemovalBatch<Key, Value> removed;
+			{
+				std::lock_guard<LockPolicy> lock(mutex_);
+				if (capacity_ == 0)
+					return;
+				auto it = index_.find(key);
+				if (it != index_.end())
+				{
+					size_t slot = it->second;
+					removals_.push(key, values_[slot], CopRemovalCause::Replaced);
+					values_[slot] = value;
+					touch(slot);
+				}
+				else
+				{
+					if (keys_.size() >= capacity_)
+						evictOne();
+					++clock_;
+					size_t slot = keys_.size();
+					keys_.push_back(key);
+					values_.push_back(value);
+					meta_[slot].store(initialMeta(), std::memory_order_relaxed);
+					index_[key] = static_cast<uint32_t>(slot);
+				}
+				removed = removals_.drain();
+			}
+			removed.deliver();
+		}
+
+		//ֻ¸òλԪϢ,ڹ
+		bool get(Key key, Value& value) override
+		{
+			CopLockOpScope opScope(CopLockOp::Get);
+			std::shared_lock<LockPolicy> lock(mutex_);
+			auto it = index_.find(key);
+			if (it == index_.end())
+				return false;
+			touch(it->second);
+			value = values_[it->second];
+			return true;
+		}
+
+		Value get(Key key) override
+		{
+			Value value{};
+			get(key, value);
+			return value;
+		}
+
+		void remove(Key key)
+		{
+			CopRemovalBatch<Key, Value> removed;
+			{
+				std::lock_guard<LockPolicy> lock(mutex_);
+				auto it = index_.find(key);
+				if (it != index_.end())
+				{
+					size_t slot = it->second;
+					removals_.push(key, values_[slot], CopRemovalCause::Explicit);
+					eraseSlot(slot);
+				}
+				removed = removals_.drain();
+			}
+			removed.deliver();
+		}
+
+		//ֻ:ԪϢ
+		bool contains(Key key)
+		{
+			std::shared_lock<LockPolicy> lock(mutex_);
+			return index_.find(key) != index_.end();
+		}
+
+		//ߵ;ʱCopResizeStep̭,ͷ
+		void setCapacity(size_t capacity)
+		{
+			{
+				std::lock_guard<LockPolicy> lock(mutex_);
+				capacity_ = capacity;
+				if (capacity > meta_.size())
+				{
+					//ԭܰ,ʱ
+					std::vector<std::atomic<uint32_t>> grown(capacity);
+					for (size_t i = 0; i < keys_.size(); ++i)
+						grown[i].store(meta_[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+					meta_.swap(grown);
+					keys_.reserve(capacity);
+					values_.reserve(capacity);
+				}
+			}
+			bool done = false;
+			while (!done)
+			{
+				CopRemovalBatch<Key, Value> removed;
+				{
+					std::lock_guard<LockPolicy> lock(mutex_);
+					for (size_t i = 0; i < CopResizeStep && keys_.size() > capacity_; ++i)
+						evictOne();
+					done = keys_.size() <= capacity_;
+					removed = removals_.drain();
+				}
+				removed.deliver();
+			}
+		}
+
+		size_t capacity()
+		{
+			std::shared_lock<LockPolicy> lock(mutex_);
+			return capacity_;
+		}
+
+		size_t size()
+		{
+			std::shared_lock<LockPolicy> lock(mutex_);
+			return keys_.size();
+		}
+
+		CopLockStats lockStats() const
+		{
+			return copLockStats(mutex_);
+		}
+
+		void setRemovalListener(ListenerPtr listener)
+		{
+			std::lock_guard<LockPolicy> lock(mutex_);
+			removals_.setListener(listener);
+		}
+
+	private:
+		using IndexMap = typename CopKeyTraits<Key>::template MapType<uint32_t>;
+
+		//LFURedisͬ:Ŀ5ʼ,ԽԽ
+		static constexpr uint32_t kLfuInit = 5;
+		static constexpr uint32_t kLfuLogFactor = 10;
+
+		struct Candidate
+		{
+			Key key;
+			uint64_t score;//ԽԽӦṋ̃
+		};
+
+		uint32_t now() const
+		{
+			return static_cast<uint32_t>(clock_);
+		}
+
+		//LFU˥,24λ
+		uint32_t period() const
+		{
+			return static_cast<uint32_t>(clock_ / std::max<size_t>(capacity_, 1)) & 0xFFFFFF;
+		}
+
+		uint32_t initialMeta() const
+		{
+			if (Mode == CopSampledMode::Lru)
+				return now();
+			return (period() << 8) | kLfuInit;
+		}
+
+		//˥ļ
+		uint32_t decayedCounter(uint32_t meta) const
+		{
+			uint32_t counter = meta & 0xFF;
+			uint32_t elapsed = (period() - (meta >> 8)) & 0xFFFFFF;
+			return elapsed >= counter ? 0 : counter - elapsed;
+		}
+
+		//һη;¿ͬʱд,ʧ²ӰЧ
+		void touch(size_t slot)
+		{
+			if (Mode == CopSampledMode::Lru)
+			{
+				meta_[slot].store(now(), std::memory_order_relaxed);
+				return;
+			}
+			uint32_t counter = decayedCounter(meta_[slot].load(std::memory_order_relaxed));
+			if (counter < 0xFF)
+			{
+				uint32_t base = counter > kLfuInit ? counter - kLfuInit : 0;
+				//1/(base*logFactor+1)ĸʼһ
+				if (static_cast<uint64_t>(copFastRand()) * (base * kLfuLogFactor + 1) <= UINT32_MAX)
+					++counter;
+			}
+			meta_[slot].store((period() << 8) | counter, std::memory_order_relaxed);
+		}
+
+		uint64_t scoreOf(size_t slot) const
+		{
+			uint32_t meta = meta_[slot].load(std::memory_order_relaxed);
+			if (Mode == CopSampledMode::Lru)
+				return static_cast<uint32_t>(now() - meta);
+			return 0xFF - decayedCounter(meta);
+		}
+
+		//ѡذ,ĩβ;ʱֻɱȳõĻĿ
+		void offer(size_t slot)
+		{
+			uint64_t score = scoreOf(slot);
+			const Key& key = keys_[slot];
+			for (const auto& candidate : pool_)
+			{
+				if (candidate.key == key)
+					return;
+			}
+			if (pool_.size() >= poolSize_)
+			{
+				if (score <= pool_.front().score)
+					return;
+				pool_.erase(pool_.begin());
+			}
+			auto pos = std::upper_bound(pool_.begin(), pool_.end(), score,
+				[](uint64_t value, const Candidate& candidate) { return value < candidate.score; });
+			pool_.insert(pos, Candidate{ key, score });
+		}
+
+		//ѡ,ȡȻЧĺѡ̭
+		//ѡغ󱻷ʹ(½)ѱɾֱӶ;²ķǵǰֵ,ѭȻ
+		void evictOne()
+		{
+			if (keys_.empty())
+				return;
+			copLockNote(CopLockOp::Evict);
+			while (true)
+			{
+				for (int i = 0; i < samples_; ++i)
+					offer(copFastRand() % keys_.size());
+				while (!pool_.empty())
+				{
+					Candidate candidate = std::move(pool_.back());
+					pool_.pop_back();
+					auto it = index_.find(candidate.key);
+					if (it == index_.end() || scoreOf(it->second) < candidate.score)
+						continue;
+					size_t slot = it->second;
+					removals_.push(keys_[slot], values_[slot], CopRemovalCause::Capacity);
+					eraseSlot(slot);
+					return;
+				}
+			}
+		}
+
+		//һλᵽɾλ,ֲλ
+		void eraseSlot(size_t slot)
+		{
+			index_.erase(keys_[slot]);
+			size_t last = keys_.size() - 1;
+			if (slot != last)
+			{
+				keys_[slot] = std::move(keys_[last]);
+				values_[slot] = std::move(values_[last]);
+				meta_[slot].store(meta_[last].load(std::memory_order_relaxed), std::memory_order_relaxed);
+				index_[keys_[slot]] = static_cast<uint32_t>(slot);
+			}
+			keys_.pop_back();
+			values_.pop_back();
+		}
+
+	private:
+		size_t capacity_;
+		int samples_;//ÿ̭Ĳ
+		size_t poolSize_;//ѡشС
+		uint64_t clock_;//߼ʱ,ÿһһ
+		LockPolicy mutex_;
+		IndexMap index_;//λ
+		std::vector<Key> keys_;
+		std::vector<Value> values_;
+		std::vector<std::atomic<uint32_t>> meta_;//Ԥ,ʱԭд
+		std::vector<Candidate> pool_;//α̭ѡ
+		CopRemovalQueue<Key, Value> removals_;
+	};
+
+	template <typename Key, typename Value, typename LockPolicy = CopMutexLock>
+	using CopSampledLruCache = CopSampledCache<Key, Value, CopSampledMode::Lru, LockPolicy>;
+
+	template <typename Key, typename Value, typename LockPolicy = CopMutexLock>
+	using CopSampledLfuCache = CopSampledCache<Key, Value, CopSampledMode::Lfu, LockPolicy>;
+
+	//̭ķƬ汾
+	template <typename Key, typename Value, CopSampledMode Mode = CopSampledMode::Lru, typename LockPolicy = CopMutexLock>
+	class CopHashSampledCache : public CopShardedCache<Key, Value, CopSampledCache<Key, Value, Mode, LockPolicy>>
+	{
+	public:
+		CopHashSampledCache(size_t capacity, int sliceNum, int samples = 5, size_t poolSize = 16)
+			:CopShardedCache<Key, Value, CopSampledCache<Key, Value, Mode, LockPolicy>>(capacity, sliceNum, samples, poolSize)
+		{}
+	};
+
+}// coloop
@@ -0,0 +1,359 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "CopCachePolicy.h"
+#include "CopCompute.h"
+#include "CopKeyTraits.h"
+#include "CopLockProfiler.h"
+#include "CopNegativeFilter.h"
+#include "CopTraceRecorder.h"
+
+namespace CopCache {
+
+	//Ƭͳƿ
+	struct CopShardStats
+	{
+		uint64_t hits;
+		uint64_t misses;
+		size_t capacity;
+		CopLockStats lock;//Ƭͳ,δʱΪ
+	};
+
+	//lookupĽ:Сδ,ȷϺ˲(ٻԴ)
+	enum class CopLookupResult
+	{
+		Hit,
+		Miss,
+		Absent
+	};
+
+	//ͨ÷Ƭ:keyĹϣֵĲʵ
+	//ֱӳоĲ,ͨCopStaticDispatch,麯
+	template <typename Key, typename Value, typename Policy>
+	class CopShardedCache : public CopComputeOps<CopShardedCache<Key, Value, Policy>, Key, Value>
+	{
+	public:
+		using PolicyType = Policy;
+
+		//policyArgsǳ⴫ÿƬԵĹ
+		template <typename... Args>
+		CopShardedCache(size_t capacity, int sliceNum, Args... policyArgs)
+			:capacity_(capacity)
+			, sliceNum_(sliceNum > 0 ? sliceNum : std::thread::hardware_concurrency())//ƬͳʼƬʹĬֵ
+			, stats_(sliceNum_)
+		{
+			size_t sliceSize = std::ceil(capacity / static_cast<double>(sliceNum_));//ÿƬĴС,ȡ
+			for (int i = 0; i < sliceNum_; ++i)
+			{
+				slices_.emplace_back(new Policy(sliceSize, policyArgs...));
+				sliceCapacity_.push_back(sliceSize);
+			}
+		}
+
+		void put(Key key, Value value)
+		{
+			size_t index = sliceIndex(key);
+			CopStaticDispatch<Policy>::put(*slices_[index], key, value);
+			bumpVersion(index);
+			if (negative_)
+				negative_->erase(key);
+			if (trace_)
+				trace_->record(key, CopTraceOp::Put, false, copPayloadBytes(value));
+		}
+
+		//ǩд,ƬҪֱ֧ǩ(CopGeneration.h)
+		template <typename Tag>
+		void put(Key key, Value value, Tag tag)
+		{
+			size_t index = sliceIndex(key);
+			slices_[index]->put(key, value, tag);
+			bumpVersion(index);
+			if (negative_)
+				negative_->erase(key);
+			if (trace_)
+				trace_->record(key, CopTraceOp::Put, false, copPayloadBytes(value));
+		}
+
+		//valueΪ
+		bool get(Key key, Value& value)
+		{
+			return lookup(key, value) == CopLookupResult::Hit;
+		}
+
+		//getͬ,ͨδк֪,÷ݴ˾ǷԴ
+		//ȲƬ,ƬδвŲ鸺:еļΪʱĸ¼ָƳͻΪ
+		CopLookupResult lookup(Key key, Value& value)
+		{
+			size_t index = sliceIndex(key);
+			bool hit = CopStaticDispatch<Policy>::get(*slices_[index], key, value);
+			(hit ? stats_[index].hits : stats_[index].misses).fetch_add(1, std::memory_order_relaxed);
+			if (trace_)
+				trace_->record(key, CopTraceOp::Get, hit, hit ? copPayloadBytes(value) : 0);
+			if (hit)
+				return CopLookupResult::Hit;
+			return negative_ && negative_->isKnownAbsent(key) ? CopLookupResult::Absent : CopLookupResult::Miss;
+		}
+
+		Value get(Key key)
+		{
+			Value value{};
+			get(key, value);
+			return value;
+		}
+
+		//ԭӶд,keyڷƬһμ(CopCompute.h)
+		template <typename Fn>
+		bool compute(Key key, Fn fn)
+		{
+			size_t index = sliceIndex(key);
+			bool present = slices_[index]->compute(key, fn);
+			bumpVersion(index);
+			if (present && negative_)
+				negative_->erase(key);
+			return present;
+		}
+
+		//:entriesΪÿ¼Ĳڼ,¼ttl/2ttl֮
+		//ڿʼ֮ǰ
+		void enableNegativeCache(size_t entries, std::chrono::milliseconds ttl)
+		{
+			negative_.reset(new CopNegativeFilter<Key>(entries, ttl));
+		}
+
+		//ҽӷʹ켣¼(CopTraceRecorder.h),ָر;ڿʼ֮ǰ
+		void setTraceRecorder(std::shared_ptr<CopTraceRecorder> recorder)
+		{
+			trace_ = std::move(recorder);
+		}
+
+		//Դȷkeyں;֮дkeyԶɾ¼
+		//¼ڼƬдʱ¼,벢putѸдļΪ
+		void markAbsent(Key key)
+		{
+			if (!negative_)
+				return;
+			size_t index = sliceIndex(key);
+			uint64_t version = sliceVersion(index);
+			negative_->markAbsent(key);
+			if (sliceVersion(index) != version)
+				negative_->erase(key);
+		}
+
+		//ƬO(1)ʧЧ,忪ֻƬй;һ
+		void invalidateAll()
+		{
+			if (negative_)
+				negative_->clear();
+			for (int i = 0; i < sliceNum_; ++i)
+			{
+				slices_[i]->invalidateAll();
+				bumpVersion(i);
+			}
+		}
+
+		template <typename Tag>
+		void invalidateTag(Tag tag)
+		{
+			for (int i = 0; i < sliceNum_; ++i)
+			{
+				slices_[i]->invalidateTag(tag);
+				bumpVersion(i);
+			}
+		}
+
+		//ÿƬmaxStepsڵ,ػյĹڽڵ
+		size_t sweepStale(size_t maxSteps = CopResizeStep)
+		{
+			size_t reclaimed = 0;
+			for (auto& slice : slices_)
+				reclaimed += slice->sweepStale(maxSteps);
+			return reclaimed;
+		}
+
+		//̨άģʽ,Ƭ(ȡ);ƬҪ֧maintain
+		void setMaintenanceSlack(size_t slack)
+		{
+			size_t sliceSlack = (slack + sliceNum_ - 1) / sliceNum_;
+			for (auto& slice : slices_)
+				slice->setMaintenanceSlack(sliceSlack);
+		}
+
+		//άƬ,شĽڵ
+		size_t maintain(size_t maxSteps = CopResizeStep)
+		{
+			size_t work = 0;
+			for (auto& slice : slices_)
+				work += slice->maintain(maxSteps);
+			return work;
+		}
+
+		//зƬͬһļ
+		template <typename TierPtr>
+		void setVictimTier(TierPtr tier)
+		{
+			for (auto& slice : slices_)
+				slice->setVictimTier(tier);
+		}
+
+		//зƬͬһƳ
+		template <typename ListenerPtr>
+		void setRemovalListener(ListenerPtr listener)
+		{
+			for (auto& slice : slices_)
+				slice->setRemovalListener(listener);
+		}
+
+		//ߵ,Ƭǰռ·;СķƬȵ
+		void setCapacity(size_t capacity)
+		{
+			std::lock_guard<std::mutex> lock(resizeMutex_);
+			size_t budget = 0;
+			for (size_t share : sliceCapacity_)
+				budget += share;
+			std::vector<size_t> shares(sliceNum_);
+			size_t assigned = 0;
+			for (int i = 0; i < sliceNum_; ++i)
+			{
+				shares[i] = budget > 0 ? static_cast<size_t>(static_cast<double>(sliceCapacity_[i]) * capacity / budget) : capacity / sliceNum_;
+				assigned += shares[i];
+			}
+			//ȡʣµĲβǰķƬ
+			for (int i = 0; assigned < capacity; i = (i + 1) % sliceNum_, ++assigned)
+				++shares[i];
+			for (int pass = 0; pass < 2; ++pass)
+			{
+				for (int i = 0; i < sliceNum_; ++i)
+				{
+					bool shrink = shares[i] < sliceCapacity_[i];
+					if (shrink == (pass == 0) && shares[i] != sliceCapacity_[i])
+						slices_[i]->setCapacity(shares[i]);
+				}
+			}
+			sliceCapacity_.swap(shares);
+			capacity_ = capacity;
+		}
+
+		//δٵķƬŲδķƬ,ֲ
+		//ÿŲƬ1/8,Ƭƽݶ1/4;ͳƼ,ѹ𽥵
+		//ǷŲ,ʺɺ̨߳ڵ
+		bool rebalance()
+		{
+			std::lock_guard<std::mutex> lock(resizeMutex_);
+			if (sliceNum_ < 2)
+				return false;
+
+			size_t budget = 0;
+			for (size_t share : sliceCapacity_)
+				budget += share;
+			size_t floor = std::max<size_t>(1, budget / sliceNum_ / 4);
+
+			int hot = 0;
+			std::vector<uint64_t> misses(sliceNum_);
+			for (int i = 0; i < sliceNum_; ++i)
+			{
+				misses[i] = stats_[i].misses.load(std::memory_order_relaxed);
+				if (misses[i] > misses[hot])
+					hot = i;
+			}
+			//ƬֻӻóķƬѡ
+			int cold = -1;
+			for (int i = 0; i < sliceNum_; ++i)
+			{
+				if (i != hot && sliceCapacity_[i] > floor && (cold < 0 || misses[i] < misses[cold]))
+					cold = i;
+			}
+
+			bool moved = false;
+			//δв಻ʱ,ض
+			if (cold >= 0 && misses[hot] >= kMinPressure && misses[hot] > 2 * misses[cold])
+			{
+				size_t step = std::max<size_t>(1, std::min(sliceCapacity_[cold] / 8, sliceCapacity_[cold] - floor));
+				sliceCapacity_[cold] -= step;
+				sliceCapacity_[hot] += step;
+				//СƬ,֤ʱԤ
+				slices_[cold]->setCapacity(sliceCapacity_[cold]);
+				slices_[hot]->setCapacity(sliceCapacity_[hot]);
+				moved = true;
+			}
+
+			for (auto& stat : stats_)
+			{
+				stat.hits.store(stat.hits.load(std::memory_order_relaxed) / 2, std::memory_order_relaxed);
+				stat.misses.store(stat.misses.load(std::memory_order_relaxed) / 2, std::memory_order_relaxed);
+			}
+			return moved;
+		}
+
+		//ĳƬϴrebalance˥ͳƺ͵ǰ
+		CopShardStats shardStats(size_t index)
+		{
+			std::lock_guard<std::mutex> lock(resizeMutex_);
+			return { stats_[index].hits.load(std::memory_order_relaxed),
+				stats_[index].misses.load(std::memory_order_relaxed),
+				sliceCapacity_[index],
+				detail::copPolicyLockStats(*slices_[index], 0) };
+		}
+
+		size_t capacity() const { return capacity_; }
+
+		int sliceNum() const { return sliceNum_; }
+
+		//keyڵķƬ±
+		size_t sliceIndexOf(const Key& key) const { return sliceIndex(key); }
+
+		//Ƭݰ汾,ÿξɱдʧЧ֮,ǰõ߳˽лУ
+		//ֱͨslice()޸ķƬ汾
+		uint64_t sliceVersion(size_t index) const
+		{
+			return stats_[index].version.load(std::memory_order_acquire);
+		}
+
+		//ֱӷĳƬ
+		Policy& slice(size_t index) { return *slices_[index]; }
+
+	protected:
+		//д֮:ȶ汾ٶ,ʱµİ汾һѾ
+		void bumpVersion(size_t index)
+		{
+			stats_[index].version.fetch_add(1, std::memory_order_release);
+		}
+
+		//keyתɶӦķƬ±
+		size_t sliceIndex(const Key& key) const
+		{
+			return CopKeyTraits<Key>::shardHash(key) % sliceNum_;
+		}
+
+	protected:
+		//ÿƬռ,ͳƼα
+		//汾ռһ:ǰûÿжҪ汾,ܱÿηʶдм
+		struct alignas(64) SliceStats
+		{
+			std::atomic<uint64_t> hits{ 0 };
+			std::atomic<uint64_t> misses{ 0 };
+			alignas(64) std::atomic<uint64_t> version{ 0 };//ݰ汾
+		};
+
+		static constexpr uint64_t kMinPressure = 64;//Ųδд
+
+		size_t capacity_;//
+		int sliceNum_;//Ƭ
+		std::vector<SliceStats> stats_;//ÿƬͳ
+		std::vector<size_t> sliceCapacity_;//ÿƬǰֵ,ܺͼȫԤ
+		std::mutex resizeMutex_;//лsetCapacityrebalance
+		std::vector<std::unique_ptr<Policy>> slices_;//Ƭ
+		std::unique_ptr<CopNegativeFilter<Key>> negative_;//,δʱΪ
+		std::shared_ptr<CopTraceRecorder> trace_;//ʹ켣¼,δҽʱΪ
+	};
+
+}// coloop
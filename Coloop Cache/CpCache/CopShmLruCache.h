@@ -0,0 +1,461 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "CopCachePolicy.h"
+#include "CopKeyTraits.h"
+
+namespace CopCache {
+
+	//̹ķƬLRU(POSIX):ݷһιڴ,̹ͬһݻ
+	//ֻ±겻ָ,ӳ䵽ַͬҲʹ;ֵƽ
+	//ÿƬһѽ̼乲³:̱,һ߻յEOWNERDEAD,
+	//ʱƬֻһ,ֱո÷Ƭٱһ,Ῠ,ֻʧһƬĻ
+	//nameǿʱʹshm_open,ִ̰ͬ;nameΪʱʹmemfd_create,
+	//fork֮ǰ,ӽ̼̳ӳ
+	//߳ʼڼжϵļ(flock,˳ʱںͷ);޵ȴȥȡ,
+	//ȡʱδʼ˵Ѿ,ɼ߰ԼĲ³ʼ,һֱס
+	template <typename Key, typename Value>
+	class CopShmLruCache : public CopCachePolicy<Key, Value>
+	{
+		static_assert(std::is_trivially_copyable<Key>::value, "CopShmLruCache: Key must be trivially copyable");
+		static_assert(std::is_trivially_copyable<Value>::value, "CopShmLruCache: Value must be trivially copyable");
+
+	public:
+		//һεĽ̸ʼ,̵ȴʼɺֱʹ,Զڼ¼Ϊ׼
+		//򿪻ʼʧʱisOpen()Ϊfalse
+		CopShmLruCache(const std::string& name, size_t capacity, int sliceNum)
+			:base_(nullptr)
+			, mappedBytes_(0)
+			, fd_(-1)
+		{
+			sliceNum = sliceNum > 0 ? sliceNum : static_cast<int>(std::thread::hardware_concurrency());
+			uint32_t slots = static_cast<uint32_t>(std::max<size_t>(1, (capacity + sliceNum - 1) / sliceNum));
+			uint32_t buckets = 1;
+			while (buckets < slots)
+				buckets <<= 1;
+			size_t total = kHeaderBytes + static_cast<size_t>(sliceNum) * sliceBytes(slots, buckets);
+
+			bool creator = true;
+			if (name.empty())
+			{
+				fd_ = memfd_create("CopShmLruCache", 0);
+			}
+			else
+			{
+				fd_ = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+				if (fd_ < 0 && errno == EEXIST)
+				{
+					creator = false;
+					fd_ = shm_open(name.c_str(), O_RDWR, 0600);
+				}
+			}
+			if (fd_ < 0)
+				return;
+
+			bool owner = creator;//Ƿɱ̳ʼ
+			if (creator)
+			{
+				if (flock(fd_, LOCK_EX) != 0)
+					return;
+			}
+			else if (!waitReady())
+			{
+				//߳ʼڼһֱ,ȡʱδ˵Ѿ˳
+				if (flock(fd_, LOCK_EX) != 0)
+					return;
+				owner = !segmentReady();
+				if (!owner)
+					flock(fd_, LOCK_UN);
+			}
+
+			if (owner)
+			{
+				if (ftruncate(fd_, static_cast<off_t>(total)) == 0)
+					attach(total);
+				if (base_)
+					initialize(static_cast<uint32_t>(sliceNum), slots, buckets);
+				flock(fd_, LOCK_UN);
+			}
+			else
+			{
+				struct stat st;
+				if (fstat(fd_, &st) == 0 && st.st_size >= static_cast<off_t>(kHeaderBytes))
+					attach(static_cast<size_t>(st.st_size));
+				//봴дľ,֮ĶͷͷƬѳʼ
+				if (base_ && header()->ready.load(std::memory_order_acquire) != kMagic)
+				{
+					munmap(base_, mappedBytes_);
+					base_ = nullptr;
+				}
+			}
+		}
+
+		//̵ֻӳ,unlinkɾ
+		~CopShmLruCache() override
+		{
+			if (base_)
+				munmap(base_, mappedBytes_);
+			if (fd_ >= 0)
+				close(fd_);
+		}
+
+		CopShmLruCache(const CopShmLruCache&) = delete;
+		CopShmLruCache& operator=(const CopShmLruCache&) = delete;
+
+		//ɾ,ѾӳĽ̲Ӱ
+		static void unlink(const std::string& name)
+		{
+			shm_unlink(name.c_str());
+		}
+
+		bool isOpen() const { return base_ != nullptr; }
+
+		void put(Key key, Value value) override
+		{
+			if (!base_)
+				return;
+			uint64_t h = hashOf(key);
+			Shard shard = shardOf(h);
+			ShardLock lock(*this, shard);
+			uint32_t index = find(shard, key, h);
+			if (index != kNil)
+			{
+				shard.nodes[index].value = value;
+				moveToFront(shard, index);
+				return;
+			}
+			if (shard.header->freeHead == kNil)
+				evictTail(shard);
+			index = shard.header->freeHead;
+			Node& node = shard.nodes[index];
+			shard.header->freeHead = node.next;
+			node.key = key;
+			node.value = value;
+			uint32_t bucket = static_cast<uint32_t>(h) & (header()->bucketsPerSlice - 1);
+			node.chain = shard.buckets[bucket];
+			shard.buckets[bucket] = index;
+			pushFront(shard, index);
+			++shard.header->size;
+		}
+
+		bool get(Key key, Value& value) override
+		{
+			if (!base_)
+				return false;
+			uint64_t h = hashOf(key);
+			Shard shard = shardOf(h);
+			ShardLock lock(*this, shard);
+			uint32_t index = find(shard, key, h);
+			if (index == kNil)
+				return false;
+			moveToFront(shard, index);
+			value = shard.nodes[index].value;
+			return true;
+		}
+
+		Value get(Key key) override
+		{
+			Value value{};
+			get(key, value);
+			return value;
+		}
+
+		void remove(Key key)
+		{
+			if (!base_)
+				return;
+			uint64_t h = hashOf(key);
+			Shard shard = shardOf(h);
+			ShardLock lock(*this, shard);
+			uint32_t index = find(shard, key, h);
+			if (index != kNil)
+				release(shard, index, h);
+		}
+
+		bool contains(Key key)
+		{
+			if (!base_)
+				return false;
+			uint64_t h = hashOf(key);
+			Shard shard = shardOf(h);
+			ShardLock lock(*this, shard);
+			return find(shard, key, h) != kNil;
+		}
+
+		size_t size()
+		{
+			size_t total = 0;
+			for (uint32_t i = 0; base_ && i < header()->sliceNum; ++i)
+			{
+				Shard shard = shardAt(i);
+				ShardLock lock(*this, shard);
+				total += shard.header->size;
+			}
+			return total;
+		}
+
+		size_t capacity() const
+		{
+			return base_ ? static_cast<size_t>(header()->sliceNum) * header()->slotsPerSlice : 0;
+		}
+
+		int sliceNum() const { return base_ ? static_cast<int>(header()->sliceNum) : 0; }
+
+		//̱յķƬ(н̺ϼ)
+		uint64_t recoveredShards() const
+		{
+			return base_ ? header()->recovered.load(std::memory_order_relaxed) : 0;
+		}
+
+	private:
+		static constexpr uint32_t kNil = 0xFFFFFFFFu;
+		static constexpr uint32_t kMagic = 0x43534C52u;//"CSLR"
+		static constexpr size_t kAlign = 64;
+		static constexpr int kInitWaitMs = 1000;//ߵȴ߳ʼʱ,ʱ鴴Ƿѱ
+
+		//ͷ,λڶεʼλ
+		struct SegmentHeader
+		{
+			std::atomic<uint32_t> ready;//ʼɺдkMagic
+			uint32_t sliceNum;
+			uint32_t slotsPerSlice;
+			uint32_t bucketsPerSlice;
+			uint64_t sliceBytes;
+			std::atomic<uint64_t> recovered;
+		};
+
+		//Ƭͷ,Ͱͽڵ
+		struct ShardHeader
+		{
+			pthread_mutex_t mutex;
+			uint32_t head;//
+			uint32_t tail;//δ
+			uint32_t freeHead;//нڵ
+			uint32_t size;
+		};
+
+		//ڵ֮ȫ±
+		struct Node
+		{
+			Key key;
+			Value value;
+			uint32_t prev;
+			uint32_t next;//LRUеһ
+			uint32_t chain;//ͬһͰеһ
+		};
+
+		//ĳƬڱ̵ַռеͼ
+		struct Shard
+		{
+			ShardHeader* header;
+			uint32_t* buckets;
+			Node* nodes;
+		};
+
+		static constexpr size_t alignUp(size_t n) { return (n + kAlign - 1) / kAlign * kAlign; }
+		static constexpr size_t kHeaderBytes = alignUp(sizeof(SegmentHeader));
+
+		static size_t sliceBytes(uint32_t slots, uint32_t buckets)
+		{
+			return alignUp(sizeof(ShardHeader)) + alignUp(sizeof(uint32_t) * buckets) + alignUp(sizeof(Node) * slots);
+		}
+
+		//ʱ̱
+		class ShardLock
+		{
+		public:
+			ShardLock(CopShmLruCache& owner, Shard& shard)
+				:mutex_(&shard.header->mutex)
+			{
+				if (pthread_mutex_lock(mutex_) == EOWNERDEAD)
+				{
+					owner.resetShard(shard);
+					owner.header()->recovered.fetch_add(1, std::memory_order_relaxed);
+					pthread_mutex_consistent(mutex_);
+				}
+			}
+
+			~ShardLock() { pthread_mutex_unlock(mutex_); }
+
+		private:
+			pthread_mutex_t* mutex_;
+		};
+
+		SegmentHeader* header() const { return reinterpret_cast<SegmentHeader*>(base_); }
+
+		//ӳ,ֱӴļͷľ
+		bool segmentReady() const
+		{
+			uint32_t ready = 0;
+			return pread(fd_, &ready, sizeof(ready), 0) == static_cast<ssize_t>(sizeof(ready)) && ready == kMagic;
+		}
+
+		//ȴɳʼ,kInitWaitMs
+		bool waitReady() const
+		{
+			auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(kInitWaitMs);
+			while (!segmentReady())
+			{
+				if (std::chrono::steady_clock::now() >= deadline)
+					return false;
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+			return true;
+		}
+
+		void attach(size_t total)
+		{
+			void* base = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+			if (base == MAP_FAILED)
+				return;
+			base_ = static_cast<char*>(base);
+			mappedBytes_ = total;
+		}
+
+		static uint64_t hashOf(const Key& key)
+		{
+			return static_cast<uint64_t>(CopKeyTraits<Key>::hash(key)) * 0x9E3779B97F4A7C15ULL;
+		}
+
+		//λѡƬ,λѡͰ
+		Shard shardOf(uint64_t h) const
+		{
+			return shardAt(static_cast<uint32_t>((h >> 32) % header()->sliceNum));
+		}
+
+		Shard shardAt(uint32_t index) const
+		{
+			char* p = base_ + kHeaderBytes + static_cast<size_t>(index) * header()->sliceBytes;
+			Shard shard;
+			shard.header = reinterpret_cast<ShardHeader*>(p);
+			shard.buckets = reinterpret_cast<uint32_t*>(p + alignUp(sizeof(ShardHeader)));
+			shard.nodes = reinterpret_cast<Node*>(p + alignUp(sizeof(ShardHeader)) + alignUp(sizeof(uint32_t) * header()->bucketsPerSlice));
+			return shard;
+		}
+
+		//ֱĴʱڿаʼ,ȫд
+		void initialize(uint32_t sliceNum, uint32_t slots, uint32_t buckets)
+		{
+			SegmentHeader* seg = header();
+			seg->ready.store(0, std::memory_order_relaxed);
+			seg->sliceNum = sliceNum;
+			seg->slotsPerSlice = slots;
+			seg->bucketsPerSlice = buckets;
+			seg->sliceBytes = sliceBytes(slots, buckets);
+			seg->recovered.store(0, std::memory_order_relaxed);
+
+			pthread_mutexattr_t attr;
+			pthread_mutexattr_init(&attr);
+			pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+			pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+			for (uint32_t i = 0; i < sliceNum; ++i)
+			{
+				Shard shard = shardAt(i);
+				pthread_mutex_init(&shard.header->mutex, &attr);
+				resetShard(shard);
+			}
+			pthread_mutexattr_destroy(&attr);
+			seg->ready.store(kMagic, std::memory_order_release);
+		}
+
+		//շƬ:Ͱÿ,ȫڵ㴮
+		void resetShard(Shard& shard)
+		{
+			uint32_t slots = header()->slotsPerSlice;
+			for (uint32_t i = 0; i < header()->bucketsPerSlice; ++i)
+				shard.buckets[i] = kNil;
+			for (uint32_t i = 0; i < slots; ++i)
+				shard.nodes[i].next = i + 1 < slots ? i + 1 : kNil;
+			shard.header->freeHead = 0;
+			shard.header->head = kNil;
+			shard.header->tail = kNil;
+			shard.header->size = 0;
+		}
+
+		uint32_t find(const Shard& shard, const Key& key, uint64_t h) const
+		{
+			uint32_t bucket = static_cast<uint32_t>(h) & (header()->bucketsPerSlice - 1);
+			for (uint32_t i = shard.buckets[bucket]; i != kNil; i = shard.nodes[i].chain)
+			{
+				if (shard.nodes[i].key == key)
+					return i;
+			}
+			return kNil;
+		}
+
+		void unlinkNode(Shard& shard, uint32_t index)
+		{
+			Node& node = shard.nodes[index];
+			if (node.prev != kNil)
+				shard.nodes[node.prev].next = node.next;
+			else
+				shard.header->head = node.next;
+			if (node.next != kNil)
+				shard.nodes[node.next].prev = node.prev;
+			else
+				shard.header->tail = node.prev;
+		}
+
+		void pushFront(Shard& shard, uint32_t index)
+		{
+			Node& node = shard.nodes[index];
+			node.prev = kNil;
+			node.next = shard.header->head;
+			if (shard.header->head != kNil)
+				shard.nodes[shard.header->head].prev = index;
+			shard.header->head = index;
+			if (shard.header->tail == kNil)
+				shard.header->tail = index;
+		}
+
+		void moveToFront(Shard& shard, uint32_t index)
+		{
+			if (shard.header->head == index)
+				return;
+			unlinkNode(shard, index);
+			pushFront(shard, index);
+		}
+
+		//Ͱժ½ڵ㲢Żؿ
+		void release(Shard& shard, uint32_t index, uint64_t h)
+		{
+			unlinkNode(shard, index);
+			uint32_t bucket = static_cast<uint32_t>(h) & (header()->bucketsPerSlice - 1);
+			uint32_t* link = &shard.buckets[bucket];
+			while (*link != index)
+				link = &shard.nodes[*link].chain;
+			*link = shard.nodes[index].chain;
+			shard.nodes[index].next = shard.header->freeHead;
+			shard.header->freeHead = index;
+			--shard.header->size;
+		}
+
+		void evictTail(Shard& shard)
+		{
+			uint32_t tail = shard.header->tail;
+			release(shard, tail, hashOf(shard.nodes[tail].key));
+		}
+
+	private:
+		char* base_;//ӳʼַ
+		size_t mappedBytes_;
+		int fd_;
+	};
+
+}// coloop
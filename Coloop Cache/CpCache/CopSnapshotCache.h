@@ -0,0 +1,360 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "CopCachePolicy.h"
+#include "CopKeyTraits.h"
+
+namespace CopCache {
+
+	//ڼԪӳٻ(EBR),ջĶʾɰ汾
+	//ÿ߳ռһռеĲλ,ڼд뵱ʱȫּԪ,;
+	//ֻдԼĲλ,дκ̹߳Ļ
+	//д滻ָƽԪ,ɰ汾ƽļԪ,ֱûвλͣڸļԪͷ
+	//߳λʱĶ߸ù,ڼͣ
+	class CopEpochDomain
+	{
+		struct Slot;
+
+	public:
+		static constexpr size_t kSlots = 256;
+
+		static CopEpochDomain& global()
+		{
+			static CopEpochDomain domain;
+			return domain;
+		}
+
+		//ٽ,ʱ,ʱ˳;Ƕ
+		class Guard
+		{
+		public:
+			explicit Guard(CopEpochDomain& domain)
+				:domain_(domain)
+				, slot_(domain.localSlot())
+			{
+				if (slot_)
+					slot_->epoch.store(domain_.epoch_.load(std::memory_order_relaxed), std::memory_order_seq_cst);
+				else
+					domain_.overflow_.fetch_add(1, std::memory_order_seq_cst);
+			}
+
+			~Guard()
+			{
+				if (slot_)
+					slot_->epoch.store(0, std::memory_order_release);
+				else
+					domain_.overflow_.fetch_sub(1, std::memory_order_release);
+			}
+
+			Guard(const Guard&) = delete;
+			Guard& operator=(const Guard&) = delete;
+
+		private:
+			CopEpochDomain& domain_;
+			Slot* slot_;
+		};
+
+		//ƽԪ,ƽֵ;滻ָ֮
+		uint64_t advance()
+		{
+			return epoch_.fetch_add(1, std::memory_order_seq_cst) + 1;
+		}
+
+		//retireEpoch֮ǰĶǷ˳
+		bool quiescent(uint64_t retireEpoch) const
+		{
+			if (overflow_.load(std::memory_order_seq_cst) != 0)
+				return false;
+			for (const auto& slot : slots_)
+			{
+				uint64_t epoch = slot.epoch.load(std::memory_order_seq_cst);
+				if (epoch != 0 && epoch < retireEpoch)
+					return false;
+			}
+			return true;
+		}
+
+	private:
+		struct alignas(64) Slot
+		{
+			std::atomic<uint64_t> epoch{ 0 };//0ʾڶٽ
+			std::atomic<bool> owned{ false };
+		};
+
+		//߳˳ʱ黹λ
+		struct SlotHolder
+		{
+			Slot* slot = nullptr;
+			~SlotHolder()
+			{
+				if (slot)
+					slot->owned.store(false, std::memory_order_release);
+			}
+		};
+
+		CopEpochDomain() :epoch_(1), overflow_(0) {}
+
+		//ÿ̵߳һζʱһвλ,֮һֱʹ;ûпвλʱnullptr
+		Slot* localSlot()
+		{
+			thread_local SlotHolder holder;
+			if (holder.slot)
+				return holder.slot;
+			for (auto& slot : slots_)
+			{
+				bool expected = false;
+				if (!slot.owned.load(std::memory_order_relaxed)
+					&& slot.owned.compare_exchange_strong(expected, true, std::memory_order_acquire))
+				{
+					holder.slot = &slot;
+					return holder.slot;
+				}
+			}
+			return nullptr;
+		}
+
+	private:
+		std::atomic<uint64_t> epoch_;
+		std::atomic<uint64_t> overflow_;
+		Slot slots_[kSlots];
+	};
+
+	//ֻջ:޸ġȡñͲұ
+	//ͨԭָһŲɱıƽϣ,ڼԪ²,Ҳдڴ
+	//дȽ,batchSizepublishʱϲ°汾滻;
+	//ǰдԶ߲ɼ,batchSizeΪ1ʱÿд
+	//capacityΪĿ,̭:ﵽ޺¼ڷʱrejected,мĸ²Ӱ
+	template <typename Key, typename Value>
+	class CopSnapshotCache : public CopCachePolicy<Key, Value>
+	{
+	public:
+		explicit CopSnapshotCache(size_t capacity, size_t batchSize = 64)
+			:capacity_(capacity)
+			, batchSize_(std::max<size_t>(batchSize, 1))
+			, table_(new Table())
+			, rejected_(0)
+			, domain_(CopEpochDomain::global())
+		{}
+
+		//ʱж
+		~CopSnapshotCache() override
+		{
+			delete table_.load(std::memory_order_relaxed);
+			for (auto& retired : retired_)
+				delete retired.first;
+		}
+
+		CopSnapshotCache(const CopSnapshotCache&) = delete;
+		CopSnapshotCache& operator=(const CopSnapshotCache&) = delete;
+
+		void put(Key key, Value value) override
+		{
+			std::lock_guard<std::mutex> lock(writeMutex_);
+			pending_[key] = Pending{ value, false };
+			if (pending_.size() >= batchSize_)
+				publishLocked();
+		}
+
+		bool get(Key key, Value& value) override
+		{
+			CopEpochDomain::Guard guard(domain_);
+			const Table* table = table_.load(std::memory_order_seq_cst);
+			const Value* found = table->find(key);
+			if (!found)
+				return false;
+			value = *found;
+			return true;
+		}
+
+		Value get(Key key) override
+		{
+			Value value{};
+			get(key, value);
+			return value;
+		}
+
+		//ɾͬҪȵŶԶЧ
+		void remove(Key key)
+		{
+			std::lock_guard<std::mutex> lock(writeMutex_);
+			pending_[key] = Pending{ Value{}, true };
+			if (pending_.size() >= batchSize_)
+				publishLocked();
+		}
+
+		//һ滻ǰ汾,δд
+		void replaceAll(const std::vector<std::pair<Key, Value>>& entries)
+		{
+			std::lock_guard<std::mutex> lock(writeMutex_);
+			pending_.clear();
+			std::vector<std::pair<Key, Value>> kept;
+			kept.reserve(std::min(entries.size(), capacity_));
+			std::unordered_map<Key, size_t> positions;
+			for (const auto& entry : entries)
+			{
+				auto it = positions.find(entry.first);
+				if (it != positions.end())
+					kept[it->second].second = entry.second;
+				else if (kept.size() < capacity_)
+				{
+					positions.emplace(entry.first, kept.size());
+					kept.push_back(entry);
+				}
+				else
+					++rejected_;
+			}
+			swapTable(new Table(std::move(kept)));
+		}
+
+		//д,غϲд
+		size_t publish()
+		{
+			std::lock_guard<std::mutex> lock(writeMutex_);
+			return publishLocked();
+		}
+
+		//ѷ汾Ŀ
+		size_t size()
+		{
+			CopEpochDomain::Guard guard(domain_);
+			return table_.load(std::memory_order_seq_cst)->size();
+		}
+
+		size_t capacity() const { return capacity_; }
+
+		//δд
+		size_t pendingSize()
+		{
+			std::lock_guard<std::mutex> lock(writeMutex_);
+			return pending_.size();
+		}
+
+		//򳬳¼
+		size_t rejected()
+		{
+			std::lock_guard<std::mutex> lock(writeMutex_);
+			return rejected_;
+		}
+
+	private:
+		//ɱĿѰַ:Ŀմ,ͰֻĿ±,װʲ1/2
+		class Table
+		{
+		public:
+			Table() :mask_(0) {}
+
+			explicit Table(std::vector<std::pair<Key, Value>> entries)
+				:entries_(std::move(entries))
+			{
+				size_t buckets = 1;
+				while (buckets < entries_.size() * 2)
+					buckets <<= 1;
+				mask_ = buckets - 1;
+				buckets_.assign(buckets, kEmpty);
+				for (size_t i = 0; i < entries_.size(); ++i)
+				{
+					size_t pos = CopKeyTraits<Key>::hash(entries_[i].first) & mask_;
+					while (buckets_[pos] != kEmpty)
+						pos = (pos + 1) & mask_;
+					buckets_[pos] = static_cast<uint32_t>(i);
+				}
+			}
+
+			const Value* find(const Key& key) const
+			{
+				if (entries_.empty())
+					return nullptr;
+				size_t pos = CopKeyTraits<Key>::hash(key) & mask_;
+				while (buckets_[pos] != kEmpty)
+				{
+					const auto& entry = entries_[buckets_[pos]];
+					if (entry.first == key)
+						return &entry.second;
+					pos = (pos + 1) & mask_;
+				}
+				return nullptr;
+			}
+
+			size_t size() const { return entries_.size(); }
+
+			const std::vector<std::pair<Key, Value>>& entries() const { return entries_; }
+
+		private:
+			static constexpr uint32_t kEmpty = UINT32_MAX;
+
+			std::vector<std::pair<Key, Value>> entries_;
+			std::vector<uint32_t> buckets_;
+			size_t mask_;
+		};
+
+		struct Pending
+		{
+			Value value;
+			bool removed;//ɾ
+		};
+
+		//ڵǰ汾Ϻϲд,°汾
+		size_t publishLocked()
+		{
+			if (pending_.empty())
+				return 0;
+			//д߳д,ǰ汾ֻᱻԼ滻,Ԫ
+			const Table* current = table_.load(std::memory_order_relaxed);
+			std::vector<std::pair<Key, Value>> entries;
+			entries.reserve(std::min(current->size() + pending_.size(), capacity_));
+			for (const auto& entry : current->entries())
+			{
+				auto it = pending_.find(entry.first);
+				if (it == pending_.end())
+					entries.push_back(entry);
+				else if (!it->second.removed)
+					entries.emplace_back(entry.first, it->second.value);
+			}
+			for (const auto& pair : pending_)
+			{
+				if (pair.second.removed || current->find(pair.first))
+					continue;
+				if (entries.size() < capacity_)
+					entries.emplace_back(pair.first, pair.second.value);
+				else
+					++rejected_;
+			}
+			size_t merged = pending_.size();
+			pending_.clear();
+			swapTable(new Table(std::move(entries)));
+			return merged;
+		}
+
+		//滻汾޶ߵľɰ汾
+		void swapTable(Table* next)
+		{
+			Table* old = table_.exchange(next, std::memory_order_seq_cst);
+			retired_.emplace_back(old, domain_.advance());
+			auto it = std::remove_if(retired_.begin(), retired_.end(), [this](const std::pair<Table*, uint64_t>& retired) {
+				if (!domain_.quiescent(retired.second))
+					return false;
+				delete retired.first;
+				return true;
+			});
+			retired_.erase(it, retired_.end());
+		}
+
+	private:
+		size_t capacity_;
+		size_t batchSize_;//дԶ
+		std::atomic<Table*> table_;//ǰ汾
+		std::unordered_map<Key, Pending> pending_;//д,ͬϲ
+		std::vector<std::pair<Table*, uint64_t>> retired_;//ȴյľɰ汾ۼԪ
+		size_t rejected_;
+		std::mutex writeMutex_;//лд
+		CopEpochDomain& domain_;
+	};
+
+}// coloop
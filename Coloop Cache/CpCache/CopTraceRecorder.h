@@ -0,0 +1,391 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "CopCachePolicy.h"
+#include "CopKeyTraits.h"
+
+namespace CopCache {
+
+	enum class CopTraceOp : uint8_t
+	{
+		Get,
+		Put,
+		Remove
+	};
+
+	//һʼ¼;ֻǹϣ,ԭʼ
+	struct CopTraceRecord
+	{
+		uint64_t timeNs = 0;//steady_clock
+		uint64_t keyHash = 0;
+		uint32_t size = 0;//ֵֽ,δʱΪ0
+		CopTraceOp op = CopTraceOp::Get;
+		bool hit = false;
+	};
+
+	//ʹ켣¼:¼ϻʵ,߻طŷ
+	//ÿ߳дԼĵߵ߻λ,¼·̹߳;
+	//ʱ¼¼,ҵ߳
+	//̨̰߳ռ,׷ӵļ:
+	//	ļͷ "COPTRC1\0" + (4ֽ)
+	//	ÿ¼ [־1ֽ:op|<<2|дС<<3][ʱzigzag䳤][ϣ8ֽ][С䳤(ѡ)]
+	//ʱ䰴ڼ¼,һ¼ͨ12~14ֽ;̵߳ļ¼ռ˳д,ʱ䲻֤
+	//ϣ,еļ¼ȫ,طʱȫӽ(SHARDS)
+	class CopTraceRecorder
+	{
+	public:
+		//sampleRateΪNʱԼ¼1/Nļ;ringSizeΪÿ̵߳Ļ,ȡ2
+		explicit CopTraceRecorder(const std::string& path, uint32_t sampleRate = 1,
+			std::chrono::milliseconds flushInterval = std::chrono::milliseconds(100), size_t ringSize = 4096)
+			:id_(nextId())
+			, sampleRate_(sampleRate > 0 ? sampleRate : 1)
+			, ringSize_(roundUp(ringSize))
+			, flushInterval_(flushInterval)
+			, out_(path, std::ios::binary | std::ios::trunc)
+			, lastTime_(0)
+			, written_(0)
+			, stop_(false)
+		{
+			if (out_)
+			{
+				std::string header("COPTRC1", 8);
+				header.append(reinterpret_cast<const char*>(&sampleRate_), sizeof(sampleRate_));
+				out_.write(header.data(), header.size());
+			}
+			flushThread_ = std::thread(&CopTraceRecorder::flushLoop, this);
+		}
+
+		//ֹ̨̲ͣ߳дʣ¼
+		~CopTraceRecorder()
+		{
+			{
+				std::lock_guard<std::mutex> lock(stopMutex_);
+				stop_ = true;
+			}
+			stopCv_.notify_one();
+			flushThread_.join();
+			std::lock_guard<std::mutex> lock(registryMutex_);
+			for (auto& ring : rings_)
+				ring->closed.store(true, std::memory_order_release);
+		}
+
+		CopTraceRecorder(const CopTraceRecorder&) = delete;
+		CopTraceRecorder& operator=(const CopTraceRecorder&) = delete;
+
+		bool isOpen() const { return static_cast<bool>(out_); }
+
+		uint32_t sampleRate() const { return sampleRate_; }
+
+		template <typename Key>
+		void record(const Key& key, CopTraceOp op, bool hit, size_t size = 0)
+		{
+			recordHash(static_cast<uint64_t>(CopKeyTraits<Key>::hash(key)), op, hit, size);
+		}
+
+		//δļֻһγ˷ȡģĿ
+		void recordHash(uint64_t keyHash, CopTraceOp op, bool hit, size_t size = 0)
+		{
+			if (sampleRate_ > 1 && ((keyHash * 0x9E3779B97F4A7C15ULL) >> 32) % sampleRate_ != 0)
+				return;
+			CopTraceRecord record;
+			record.timeNs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count());
+			record.keyHash = keyHash;
+			record.size = static_cast<uint32_t>(std::min<size_t>(size, UINT32_MAX));
+			record.op = op;
+			record.hit = hit;
+			localRing()->push(record);
+		}
+
+		//ռ̵߳Ļ岢дļ,дļ¼;Ҳɵ÷
+		size_t flush()
+		{
+			std::lock_guard<std::mutex> flushLock(flushMutex_);
+			std::vector<std::shared_ptr<Ring>> rings;
+			{
+				std::lock_guard<std::mutex> lock(registryMutex_);
+				rings = rings_;
+			}
+			std::string buffer;
+			size_t count = 0;
+			for (auto& ring : rings)
+			{
+				count += ring->drain([this, &buffer](const CopTraceRecord& record) {
+					encode(record, buffer);
+				});
+			}
+			if (!buffer.empty() && out_)
+			{
+				out_.write(buffer.data(), buffer.size());
+				out_.flush();
+			}
+			written_.fetch_add(count, std::memory_order_relaxed);
+			rings.clear();
+			pruneExitedThreads();
+			return count;
+		}
+
+		//дļ¼
+		uint64_t written() const { return written_.load(std::memory_order_relaxed); }
+
+		//򻺳ļ¼
+		uint64_t dropped()
+		{
+			std::lock_guard<std::mutex> lock(registryMutex_);
+			uint64_t total = droppedByExited_;
+			for (auto& ring : rings_)
+				total += ring->dropped.load(std::memory_order_relaxed);
+			return total;
+		}
+
+	private:
+		//(߳)(дļ߳)λ
+		struct Ring
+		{
+			explicit Ring(size_t size) :records(size), mask(size - 1) {}
+
+			void push(const CopTraceRecord& record)
+			{
+				uint64_t head = this->head.load(std::memory_order_relaxed);
+				if (head - tail.load(std::memory_order_acquire) > mask)
+				{
+					dropped.store(dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+					return;
+				}
+				records[head & mask] = record;
+				this->head.store(head + 1, std::memory_order_release);
+			}
+
+			template <typename Fn>
+			size_t drain(Fn fn)
+			{
+				uint64_t tail = this->tail.load(std::memory_order_relaxed);
+				uint64_t head = this->head.load(std::memory_order_acquire);
+				for (uint64_t pos = tail; pos != head; ++pos)
+					fn(records[pos & mask]);
+				this->tail.store(head, std::memory_order_release);
+				return static_cast<size_t>(head - tail);
+			}
+
+			std::vector<CopTraceRecord> records;
+			size_t mask;
+			alignas(64) std::atomic<uint64_t> head{ 0 };//ֻ߳д
+			alignas(64) std::atomic<uint64_t> tail{ 0 };//ֻдļ߳д
+			std::atomic<uint64_t> dropped{ 0 };//ֻ߳д
+			std::atomic<bool> closed{ false };//¼,̲߳Զ
+		};
+
+		using RingPtr = std::shared_ptr<Ring>;
+
+		static uint64_t nextId()
+		{
+			static std::atomic<uint64_t> id{ 0 };
+			return ++id;
+		}
+
+		static size_t roundUp(size_t size)
+		{
+			size_t result = 64;
+			while (result < size)
+				result <<= 1;
+			return result;
+		}
+
+		//߳ڸü¼µĻ,һμ¼ʱǼ;̺߳ͼ¼ͬ
+		Ring* localRing()
+		{
+			thread_local std::vector<std::pair<uint64_t, RingPtr>> local;
+			for (auto& entry : local)
+			{
+				if (entry.first == id_)
+					return entry.second.get();
+			}
+			//˳ټ¼Ļ
+			for (size_t i = 0; i < local.size();)
+			{
+				if (local[i].second->closed.load(std::memory_order_acquire))
+				{
+					local[i] = std::move(local.back());
+					local.pop_back();
+				}
+				else
+					++i;
+			}
+			RingPtr ring = std::make_shared<Ring>(ringSize_);
+			{
+				std::lock_guard<std::mutex> lock(registryMutex_);
+				rings_.push_back(ring);
+			}
+			local.emplace_back(id_, ring);
+			return ring.get();
+		}
+
+		//߳˳󻺳ֻʣ¼,дպƳ
+		void pruneExitedThreads()
+		{
+			std::lock_guard<std::mutex> lock(registryMutex_);
+			for (size_t i = 0; i < rings_.size();)
+			{
+				RingPtr& ring = rings_[i];
+				if (ring.use_count() == 1
+					&& ring->head.load(std::memory_order_acquire) == ring->tail.load(std::memory_order_relaxed))
+				{
+					droppedByExited_ += ring->dropped.load(std::memory_order_relaxed);
+					ring = std::move(rings_.back());
+					rings_.pop_back();
+				}
+				else
+					++i;
+			}
+		}
+
+		static void putVarint(uint64_t value, std::string& out)
+		{
+			while (value >= 0x80)
+			{
+				out.push_back(static_cast<char>(value | 0x80));
+				value >>= 7;
+			}
+			out.push_back(static_cast<char>(value));
+		}
+
+		void encode(const CopTraceRecord& record, std::string& out)
+		{
+			uint8_t flags = static_cast<uint8_t>(record.op)
+				| (record.hit ? 0x04 : 0)
+				| (record.size ? 0x08 : 0);
+			out.push_back(static_cast<char>(flags));
+			int64_t delta = static_cast<int64_t>(record.timeNs - lastTime_);
+			putVarint((static_cast<uint64_t>(delta) << 1) ^ static_cast<uint64_t>(delta >> 63), out);
+			lastTime_ = record.timeNs;
+			out.append(reinterpret_cast<const char*>(&record.keyHash), sizeof(record.keyHash));
+			if (record.size)
+				putVarint(record.size, out);
+		}
+
+		void flushLoop()
+		{
+			std::unique_lock<std::mutex> lock(stopMutex_);
+			while (!stop_)
+			{
+				stopCv_.wait_for(lock, flushInterval_, [this] { return stop_; });
+				lock.unlock();
+				flush();
+				lock.lock();
+			}
+		}
+
+	private:
+		uint64_t id_;//ͬһ߳µĶ¼
+		uint32_t sampleRate_;
+		size_t ringSize_;
+		std::chrono::milliseconds flushInterval_;
+		std::ofstream out_;
+		uint64_t lastTime_;//һд¼ʱ,ֱ
+		std::atomic<uint64_t> written_;
+		std::vector<RingPtr> rings_;//̵߳Ļ
+		uint64_t droppedByExited_ = 0;//ƳĶ
+		std::mutex registryMutex_;
+		std::mutex flushMutex_;//лдļ
+		bool stop_;
+		std::mutex stopMutex_;
+		std::condition_variable stopCv_;
+		std::thread flushThread_;
+	};
+
+	//ȡ켣ļ,ص;ļͷԷfalse,ĩβļ¼
+	inline bool copReadTrace(const std::string& path, const std::function<void(const CopTraceRecord&)>& fn,
+		uint32_t* sampleRate = nullptr)
+	{
+		std::ifstream in(path, std::ios::binary);
+		std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+		if (content.size() < 12 || std::memcmp(content.data(), "COPTRC1", 8) != 0)
+			return false;
+		if (sampleRate)
+			std::memcpy(sampleRate, content.data() + 8, sizeof(uint32_t));
+		size_t pos = 12;
+		auto getVarint = [&content, &pos](uint64_t& value) {
+			value = 0;
+			for (int shift = 0; shift < 64 && pos < content.size(); shift += 7)
+			{
+				uint8_t byte = static_cast<uint8_t>(content[pos++]);
+				value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+				if (!(byte & 0x80))
+					return true;
+			}
+			return false;
+		};
+		uint64_t time = 0;
+		while (pos < content.size())
+		{
+			CopTraceRecord record;
+			uint8_t flags = static_cast<uint8_t>(content[pos++]);
+			uint64_t zigzag = 0;
+			if (!getVarint(zigzag) || pos + sizeof(uint64_t) > content.size())
+				break;
+			time += static_cast<uint64_t>(static_cast<int64_t>(zigzag >> 1) ^ -static_cast<int64_t>(zigzag & 1));
+			record.timeNs = time;
+			std::memcpy(&record.keyHash, content.data() + pos, sizeof(uint64_t));
+			pos += sizeof(uint64_t);
+			uint64_t size = 0;
+			if ((flags & 0x08) && !getVarint(size))
+				break;
+			record.size = static_cast<uint32_t>(size);
+			record.op = static_cast<CopTraceOp>(flags & 0x03);
+			record.hit = (flags & 0x04) != 0;
+			fn(record);
+		}
+		return true;
+	}
+
+	//ԼϹ켣¼İװ,ӿڲ;ƬֱsetTraceRecorder
+	template <typename Key, typename Value>
+	class CopTracedCache : public CopCachePolicy<Key, Value>
+	{
+	public:
+		CopTracedCache(CopCachePolicy<Key, Value>& inner, std::shared_ptr<CopTraceRecorder> recorder)
+			:inner_(inner)
+			, recorder_(std::move(recorder))
+		{}
+
+		void put(Key key, Value value) override
+		{
+			recorder_->record(key, CopTraceOp::Put, false, copPayloadBytes(value));
+			inner_.put(key, value);
+		}
+
+		bool get(Key key, Value& value) override
+		{
+			bool hit = inner_.get(key, value);
+			recorder_->record(key, CopTraceOp::Get, hit, hit ? copPayloadBytes(value) : 0);
+			return hit;
+		}
+
+		Value get(Key key) override
+		{
+			Value value{};
+			get(key, value);
+			return value;
+		}
+
+	private:
+		CopCachePolicy<Key, Value>& inner_;
+		std::shared_ptr<CopTraceRecorder> recorder_;
+	};
+
+}// coloop
@@ -0,0 +1,257 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "CopBackingStore.h"
+#include "CopCachePolicy.h"
+#include "CopCompute.h"
+#include "CopEvictionListener.h"
+#include "CopKeyTraits.h"
+
+namespace CopCache {
+
+	//дģʽ:putֻд沢,̨̰߳ݺϲд
+	//ͬһдֵֻ;ݳʱputȴ̨д
+	//ݱ̭ʱһд,ֻ
+	//ͬһд밴ֶμ,뻺水ͬ˳;δлʱУֶΰ汾,ú˾ֵд
+	//PolicyΪеĻ,Ҫ֧computesetRemovalListener(LRU/LFU/SLRUƬ汾),
+	//Ƴɱռ
+	template <typename Key, typename Value, typename Policy>
+	class CopWriteBehindCache : public CopCachePolicy<Key, Value>
+	{
+	public:
+		using StorePtr = std::shared_ptr<CopBackingStore<Key, Value>>;
+
+		//policyArgsΪPolicyĹ
+		template <typename... Args>
+		CopWriteBehindCache(StorePtr store, size_t maxDirtyBytes, std::chrono::milliseconds flushInterval,
+			Args... policyArgs)
+			:policy_(policyArgs...)
+			, store_(std::move(store))
+			, maxDirtyBytes_(maxDirtyBytes)
+			, flushInterval_(flushInterval)
+			, dirtyBytes_(0)
+			, stop_(false)
+		{
+			policy_.setRemovalListener(std::make_shared<DirtyEvictionListener>(this));
+			flushThread_ = std::thread(&CopWriteBehindCache::flushLoop, this);
+		}
+
+		//˳ǰдȫ
+		~CopWriteBehindCache() override
+		{
+			{
+				std::lock_guard<std::mutex> lock(dirtyMutex_);
+				stop_ = true;
+			}
+			flushCv_.notify_one();
+			flushThread_.join();
+		}
+
+		CopWriteBehindCache(const CopWriteBehindCache&) = delete;
+		CopWriteBehindCache& operator=(const CopWriteBehindCache&) = delete;
+
+		void put(Key key, Value value) override
+		{
+			size_t stripe = stripeOf(key);
+			std::lock_guard<std::mutex> stripeLock(stripes_[stripe].mutex);
+			++stripes_[stripe].version;
+			{
+				std::unique_lock<std::mutex> lock(dirtyMutex_);
+				auto it = dirty_.find(key);
+				if (it != dirty_.end())
+				{
+					dirtyBytes_ -= copPayloadBytes(it->first) + copPayloadBytes(it->second);
+					it->second = value;
+				}
+				else
+				{
+					dirty_.emplace(key, value);
+				}
+				dirtyBytes_ += copPayloadBytes(key) + copPayloadBytes(value);
+				//ݳ:Ѻ̨̲߳ȴд
+				if (dirtyBytes_ > maxDirtyBytes_)
+				{
+					flushCv_.notify_one();
+					drainedCv_.wait(lock, [this] { return dirtyBytes_ <= maxDirtyBytes_ || stop_; });
+				}
+			}
+			//Գзֶ,ͬĲд밴ͬ˳򵽴ͻ
+			policy_.put(key, value);
+		}
+
+		//β黺桢(д)ͺ,Ӻ˶ݷŻػ
+		//ڼֶͬйдʱ²,ѾֵŻػ
+		bool get(Key key, Value& value) override
+		{
+			size_t stripe = stripeOf(key);
+			while (true)
+			{
+				if (policy_.get(key, value))
+					return true;
+				uint64_t version;
+				{
+					std::lock_guard<std::mutex> stripeLock(stripes_[stripe].mutex);
+					version = stripes_[stripe].version;
+				}
+				{
+					std::lock_guard<std::mutex> lock(dirtyMutex_);
+					auto it = dirty_.find(key);
+					if (it != dirty_.end())
+					{
+						value = it->second;
+						return true;
+					}
+					it = inflight_.find(key);
+					if (it != inflight_.end())
+					{
+						value = it->second;
+						return true;
+					}
+				}
+				if (!store_->load(key, value))
+					return false;
+				std::lock_guard<std::mutex> stripeLock(stripes_[stripe].mutex);
+				if (stripes_[stripe].version != version)
+					continue;
+				//ʱԻΪ׼
+				policy_.compute(key, [&value](Value& cached, bool present) {
+					if (present)
+					{
+						value = cached;
+						return CopComputeAction::Keep;
+					}
+					cached = value;
+					return CopComputeAction::Store;
+				});
+				return true;
+			}
+		}
+
+		Value get(Key key) override
+		{
+			Value value{};
+			get(key, value);
+			return value;
+		}
+
+		//ѵǰд,д
+		size_t flush()
+		{
+			std::lock_guard<std::mutex> flushLock(flushMutex_);
+			std::vector<std::pair<Key, Value>> batch;
+			{
+				std::lock_guard<std::mutex> lock(dirtyMutex_);
+				if (dirty_.empty())
+					return 0;
+				inflight_.swap(dirty_);
+				dirtyBytes_ = 0;
+				batch.assign(inflight_.begin(), inflight_.end());
+			}
+			drainedCv_.notify_all();
+			//дڼ䲻,putgetӰ;ܴinflight_
+			store_->storeBatch(batch);
+			{
+				std::lock_guard<std::mutex> lock(dirtyMutex_);
+				inflight_.clear();
+			}
+			return batch.size();
+		}
+
+		size_t dirtyBytes()
+		{
+			std::lock_guard<std::mutex> lock(dirtyMutex_);
+			return dirtyBytes_;
+		}
+
+		Policy& policy() { return policy_; }
+
+	private:
+		static constexpr size_t kStripes = 64;
+
+		//д˳:ͬһͬһֶ
+		struct alignas(64) Stripe
+		{
+			std::mutex mutex;
+			uint64_t version = 0;//ֶÿд
+		};
+
+		static size_t stripeOf(const Key& key)
+		{
+			return CopKeyTraits<Key>::shardHash(key) % kStripes;
+		}
+
+		class DirtyEvictionListener : public CopEvictionListener<Key, Value>
+		{
+		public:
+			explicit DirtyEvictionListener(CopWriteBehindCache* owner) :owner_(owner) {}
+
+			void onRemoval(const std::vector<CopRemovalNotice<Key, Value>>& notices) override
+			{
+				owner_->onRemoval(notices);
+			}
+
+		private:
+			CopWriteBehindCache* owner_;
+		};
+
+		//̭δдʱд
+		void onRemoval(const std::vector<CopRemovalNotice<Key, Value>>& notices)
+		{
+			bool evictedDirty = false;
+			{
+				std::lock_guard<std::mutex> lock(dirtyMutex_);
+				for (const auto& notice : notices)
+				{
+					if (notice.cause == CopRemovalCause::Capacity && dirty_.count(notice.key))
+					{
+						evictedDirty = true;
+						break;
+					}
+				}
+			}
+			if (evictedDirty)
+				flush();
+		}
+
+		void flushLoop()
+		{
+			std::unique_lock<std::mutex> lock(dirtyMutex_);
+			while (!stop_)
+			{
+				flushCv_.wait_for(lock, flushInterval_, [this] { return stop_ || dirtyBytes_ > maxDirtyBytes_; });
+				lock.unlock();
+				flush();
+				lock.lock();
+			}
+			lock.unlock();
+			flush();
+			drainedCv_.notify_all();
+		}
+
+	private:
+		Policy policy_;
+		StorePtr store_;
+		size_t maxDirtyBytes_;//
+		std::chrono::milliseconds flushInterval_;//д
+
+		std::unordered_map<Key, Value> dirty_;//д,ͬϲ
+		std::unordered_map<Key, Value> inflight_;//д˵
+		size_t dirtyBytes_;
+		bool stop_;
+		std::mutex dirtyMutex_;
+		std::condition_variable flushCv_;//Ѻ̨߳
+		std::condition_variable drainedCv_;//дѵȴput
+		std::mutex flushMutex_;//лд,֤˰д˳յ
+		Stripe stripes_[kStripes];//dirtyMutex_ͻڲ֮ǰȡ
+		std::thread flushThread_;
+	};
+
+}// coloop
@@ -5,11 +5,23 @@
 #include <iomanip>
 #include <random>
 #include <algorithm>
+#include <array>
+#include <cmath>
 
 #include "CopCachePolicy.h"
 #include "CopLfuCache.h"
 #include "CopLruCache.h"
 #include "CopArcCache/CopArcCache.h"
+#include "CopArcCache/CopArcAdaptiveCache.h"
+#include "CopAdaptiveCache.h"
+#include "CopCompactLfuCache.h"
+#include "CopSampledCache.h"
+#include "CopGdsfCache.h"
+#ifndef _WIN32
+#include <csignal>
+#include <sys/wait.h>
+#include "CopShmLruCache.h"
+#endif
 
 //ʱ
 class Timer {
@@ -41,6 +53,22 @@ void printResult(const std::string& testName, int capacity,
 		<< (100.0 * hits[1] / get_operations[1]) << "%" << std::endl;
 	std::cout << "ARC - Hit rate: " << std::fixed << std::setprecision(2)
 		<< (100.0 * hits[2] / get_operations[2]) << "%" << std::endl;
+	std::cout << "ARC(p) - Hit rate: " << std::fixed << std::setprecision(2)
+		<< (100.0 * hits[3] / get_operations[3]) << "%" << std::endl;
+	std::cout << "SLRU - Hit rate: " << std::fixed << std::setprecision(2)
+		<< (100.0 * hits[4] / get_operations[4]) << "%" << std::endl;
+	std::cout << "Adaptive - Hit rate: " << std::fixed << std::setprecision(2)
+		<< (100.0 * hits[5] / get_operations[5]) << "%" << std::endl;
+}
+
+//Ϊ:ÿӡ,ʧʱmainط
+int regressionFailures = 0;
+
+void check(bool ok, const std::string& name) {
+	std::cout << (ok ? "PASS " : "FAIL ") << name << std::endl;
+	if (!ok) {
+		++regressionFailures;
+	}
 }
 
 void testHotDataAccess() {
@@ -54,14 +82,17 @@ void testHotDataAccess() {
 	CopCache::CopLruCache<int, std::string> lru(CAPACITY);
 	CopCache::CopLfuCache<int, std::string> lfu(CAPACITY);
 	CopCache::CopArcCache<int, std::string> arc(CAPACITY);
+	CopCache::CopArcAdaptiveCache<int, std::string> arcP(CAPACITY);
+	CopCache::CopSlruCache<int, std::string> slru(CAPACITY);
+	CopCache::CopAdaptiveCache<int, std::string> adaptive(CAPACITY);
 	
 	std::random_device rd;//
 	std::mt19937 gen(rd());//α
 
 
-	std::array<CopCache::CopCachePolicy<int, std::string>*, 3> caches = { &lru,&lfu,&arc };
-	std::vector<int> hits(3, 0);
-	std::vector<int> get_operations(3, 0);
+	std::array<CopCache::CopCachePolicy<int, std::string>*, 6> caches = { &lru,&lfu,&arc,&arcP,&slru,&adaptive };
+	std::vector<int> hits(6, 0);
+	std::vector<int> get_operations(6, 0);
 
 	//
 	for (int i = 0; i < caches.size(); ++i)
@@ -110,10 +141,13 @@ void testLoopPattern() {
 	CopCache::CopLruCache<int, std::string> lru(CAPACITY);
 	CopCache::CopLfuCache<int, std::string> lfu(CAPACITY);
 	CopCache::CopArcCache<int, std::string> arc(CAPACITY);
+	CopCache::CopArcAdaptiveCache<int, std::string> arcP(CAPACITY);
+	CopCache::CopSlruCache<int, std::string> slru(CAPACITY);
+	CopCache::CopAdaptiveCache<int, std::string> adaptive(CAPACITY);
 
-	std::array<CopCache::CopCachePolicy<int, std::string>*, 3> caches = { &lru,&lfu,&arc };
-	std::vector<int> hits(3, 0);
-	std::vector<int> get_operations(3, 0);
+	std::array<CopCache::CopCachePolicy<int, std::string>*, 6> caches = { &lru,&lfu,&arc,&arcP,&slru,&adaptive };
+	std::vector<int> hits(6, 0);
+	std::vector<int> get_operations(6, 0);
 
 	std::random_device rd;//
 	std::mt19937 gen(rd());//α
@@ -162,13 +196,16 @@ void testWorkloadShift() {
 	CopCache::CopLruCache<int, std::string> lru(CAPACITY);
 	CopCache::CopLfuCache<int, std::string> lfu(CAPACITY);
 	CopCache::CopArcCache<int, std::string> arc(CAPACITY);
+	CopCache::CopArcAdaptiveCache<int, std::string> arcP(CAPACITY);
+	CopCache::CopSlruCache<int, std::string> slru(CAPACITY);
+	CopCache::CopAdaptiveCache<int, std::string> adaptive(CAPACITY);
 
 	std::random_device rd;
 	std::mt19937 gen(rd());
 
-	std::array<CopCache::CopCachePolicy<int, std::string>*, 3> caches = { &lru,&lfu,&arc};
-	std::vector<int> hits(3, 0);
-	std::vector<int> get_operations(3, 0);
+	std::array<CopCache::CopCachePolicy<int, std::string>*, 6> caches = { &lru,&lfu,&arc,&arcP,&slru,&adaptive };
+	std::vector<int> hits(6, 0);
+	std::vector<int> get_operations(6, 0);
 
 	//һЩʼ
 	for (int i = 0; i < caches.size(); ++i) {
@@ -224,10 +261,404 @@ void testWorkloadShift() {
 	printResult("Drastic changes in workload testing", CAPACITY, get_operations, hits);
 }
 
+//΢׼:ָͨ麯뾲̬ɵĺʱԱ
+//ʹCopNullLock,ڸǷɿ
+void testStaticDispatch() {
+	std::cout << "\n=== Test scenario 4: Virtual vs static dispatch ===" << std::endl;
+
+	const int CAPACITY = 1000;
+	const int OPERATIONS = 5000000;
+
+	using LruType = CopCache::CopLruCache<int, int, CopCache::CopNullLock>;
+	LruType lru(CAPACITY);
+	for (int key = 0; key < CAPACITY; ++key) {
+		lru.put(key, key);
+	}
+	//volatileָñ޷ƶ϶̬,òᱻȥ黯
+	CopCache::CopCachePolicy<int, int>* volatile base = &lru;
+
+	long long checksum = 0;//ۼӽ,ֹѭŻ
+	int value = 0;
+
+	Timer virtualTimer;
+	for (int op = 0; op < OPERATIONS; ++op) {
+		if (base->get(op % CAPACITY, value)) {
+			checksum += value;
+		}
+	}
+	double virtualMs = virtualTimer.elapsed();
+
+	Timer staticTimer;
+	for (int op = 0; op < OPERATIONS; ++op) {
+		if (CopCache::CopStaticDispatch<LruType>::get(lru, op % CAPACITY, value)) {
+			checksum += value;
+		}
+	}
+	double staticMs = staticTimer.elapsed();
+
+	std::cout << "get operations: " << OPERATIONS << std::endl;
+	std::cout << "Virtual dispatch: " << virtualMs << " ms" << std::endl;
+	std::cout << "Static dispatch: " << staticMs << " ms" << std::endl;
+	std::cout << "checksum: " << checksum << std::endl;
+}
+
+//ȵ㼯ϻһ˳ɨ:ɨÿֻһ,ɨڼȵԽϵƵʱ
+//LRUȵᱻɨ,SLRUȵڱ,ɨֻˢö
+void testScanResistance() {
+	std::cout << "\n=== Test scenario 5: Hot set with a one-pass scan ===" << std::endl;
+
+	const int CAPACITY = 100;
+	const int HOT_KEYS = 60;//СSLRUĬϵı(80%)
+	const int SCAN_KEYS = 20000;//һɨļ
+	const int HOT_EVERY = 50;//ɨڼÿٸɨһȵ
+
+	CopCache::CopLruCache<int, std::string> lru(CAPACITY);
+	CopCache::CopLfuCache<int, std::string> lfu(CAPACITY);
+	CopCache::CopArcCache<int, std::string> arc(CAPACITY);
+	CopCache::CopArcAdaptiveCache<int, std::string> arcP(CAPACITY);
+	CopCache::CopSlruCache<int, std::string> slru(CAPACITY);
+	CopCache::CopAdaptiveCache<int, std::string> adaptive(CAPACITY);
+
+	std::array<CopCache::CopCachePolicy<int, std::string>*, 6> caches = { &lru,&lfu,&arc,&arcP,&slru,&adaptive };
+	std::vector<int> hits(6, 0);
+	std::vector<int> get_operations(6, 0);
+	std::vector<int> survivors(6, 0);
+
+	for (size_t i = 0; i < caches.size(); ++i) {
+		//͸:δʱд
+		auto access = [&](int key) {
+			std::string result;
+			if (caches[i]->get(key, result)) {
+				return true;
+			}
+			caches[i]->put(key, "value" + std::to_string(key));
+			return false;
+		};
+
+		//Ԥ:ÿȵ
+		for (int round = 0; round < 3; ++round) {
+			for (int key = 0; key < HOT_KEYS; ++key) {
+				access(key);
+			}
+		}
+
+		//ɨ,ֻͳɨڼȵķ
+		int hot = 0;
+		for (int n = 0; n < SCAN_KEYS; ++n) {
+			access(HOT_KEYS + n);
+			if (n % HOT_EVERY == 0) {
+				get_operations[i]++;
+				if (access(hot)) {
+					hits[i]++;
+				}
+				hot = (hot + 1) % HOT_KEYS;
+			}
+		}
+
+		for (int key = 0; key < HOT_KEYS; ++key) {
+			std::string result;
+			if (caches[i]->get(key, result)) {
+				survivors[i]++;
+			}
+		}
+	}
+
+	printResult("Hot set with a one-pass scan", CAPACITY, get_operations, hits);
+	std::cout << "hot keys left after the scan: LRU " << survivors[0] << ", SLRU " << survivors[4]
+		<< " of " << HOT_KEYS << std::endl;
+	check(survivors[4] == HOT_KEYS && slru.protectedSize() >= static_cast<size_t>(HOT_KEYS),
+		"SLRU: protected segment survives a one-pass scan");
+	//ӦвӦԵںѡõһ(LRU/LFU/ARC/SLRU)
+	int best = std::max({ hits[0], hits[1], hits[2], hits[4] });
+	check(hits[5] * 100 >= best * 95, "Adaptive: hit rate stays close to the best candidate policy");
+}
+
+//Zipf(0.9)ʹ켣:10000,̶;ÿηһƫƵռ֮,ģڵһɨ
+std::vector<int> makeZipfTrace() {
+	const int KEYS = 10000;
+	const int OPERATIONS = 400000;
+
+	std::mt19937 gen(1);//̶,ɸ
+	std::vector<double> weights;
+	for (int rank = 1; rank <= KEYS; ++rank) {
+		weights.push_back(1.0 / std::pow(rank, 0.9));
+	}
+	std::discrete_distribution<int> zipf(weights.begin(), weights.end());
+
+	std::vector<int> trace;
+	trace.reserve(OPERATIONS);
+	for (int op = 0; op < OPERATIONS; ++op) {
+		int key = zipf(gen);
+		if (op > OPERATIONS / 2 && op % 3 == 0) {
+			key += 20000 + op % 5000;
+		}
+		trace.push_back(key);
+	}
+	return trace;
+}
+
+//͸ʽطŹ켣,(ٷֱ)
+template <typename Cache>
+double replayHitRate(Cache& cache, const std::vector<int>& trace) {
+	int hits = 0;
+	int value = 0;
+	for (int key : trace) {
+		if (cache.get(key, value)) {
+			hits++;
+		}
+		else {
+			cache.put(key, key);
+		}
+	}
+	return 100.0 * hits / trace.size();
+}
+
+void testZipfLateScan() {
+	std::cout << "\n=== Test scenario 6: Zipf(0.9) trace with a late scan ===" << std::endl;
+
+	const int CAPACITY = 500;
+	std::vector<int> trace = makeZipfTrace();
+
+	CopCache::CopLruCache<int, int> lru(CAPACITY);
+	CopCache::CopLfuCache<int, int> lfu(CAPACITY);
+	CopCache::CopCompactLfuCache<int, int> compactLfu(CAPACITY);
+	CopCache::CopSampledLruCache<int, int> sampledLru(CAPACITY);
+	CopCache::CopSampledLfuCache<int, int> sampledLfu(CAPACITY);
+	CopCache::CopArcCache<int, int> arc(CAPACITY);
+	CopCache::CopSlruCache<int, int> slru(CAPACITY);
+	//LRU,ҪӰӻлԲܽӽõĺѡ
+	CopCache::CopAdaptiveCache<int, int> adaptive(CAPACITY, 16, 1000, CopCache::CopPolicyKind::Lru);
+
+	std::cout << "cache size: " << CAPACITY << std::endl;
+	double lruRate = replayHitRate(lru, trace);
+	double lfuRate = replayHitRate(lfu, trace);
+	double arcRate = replayHitRate(arc, trace);
+	double slruRate = replayHitRate(slru, trace);
+	double adaptiveRate = replayHitRate(adaptive, trace);
+	std::cout << "LRU - Hit rate: " << std::fixed << std::setprecision(2) << lruRate << "%" << std::endl;
+	std::cout << "LFU - Hit rate: " << std::fixed << std::setprecision(2) << lfuRate << "%" << std::endl;
+	std::cout << "ARC - Hit rate: " << std::fixed << std::setprecision(2) << arcRate << "%" << std::endl;
+	std::cout << "SLRU - Hit rate: " << std::fixed << std::setprecision(2) << slruRate << "%" << std::endl;
+	std::cout << "Adaptive - Hit rate: " << std::fixed << std::setprecision(2) << adaptiveRate << "%" << std::endl;
+	std::cout << "Compact LFU - Hit rate: " << std::fixed << std::setprecision(2)
+		<< replayHitRate(compactLfu, trace) << "%" << std::endl;
+	//̭,СΧڲ
+	std::cout << "Sampled LRU - Hit rate: " << std::fixed << std::setprecision(2)
+		<< replayHitRate(sampledLru, trace) << "%" << std::endl;
+	std::cout << "Sampled LFU - Hit rate: " << std::fixed << std::setprecision(2)
+		<< replayHitRate(sampledLfu, trace) << "%" << std::endl;
+
+	double best = std::max({ lruRate, lfuRate, arcRate, slruRate });
+	check(adaptiveRate >= best - 2.0, "Adaptive: switching from LRU ends close to the best candidate policy");
+}
+
+//LFU:ƽʱϻ,255Ͷ,ȵ˱̭
+void checkCompactLfuCounters() {
+	const int MAX_AVERAGE = 10;
+	CopCache::CopCompactLfuCache<int, int> aging(4, MAX_AVERAGE);
+	for (int key = 1; key <= 4; ++key) {
+		aging.put(key, key);
+	}
+	int value = 0;
+	for (int n = 0; n < 1000; ++n) {
+		aging.get(1, value);
+	}
+	//ÿϻǰм֮Ϊ 4*(MAX_AVERAGE+1),ȵļᳬ
+	check(aging.frequency(1) > 1 && aging.frequency(1) <= 4 * (MAX_AVERAGE + 1),
+		"Compact LFU: aging keeps counters bounded by the average limit");
+	aging.put(5, 5);
+	aging.put(6, 6);
+	check(aging.frequency(1) > 0, "Compact LFU: hot key survives eviction after aging");
+
+	CopCache::CopCompactLfuCache<int, int> saturating(4, 1000000);//ϻ
+	saturating.put(1, 1);
+	for (int n = 0; n < 1000; ++n) {
+		saturating.get(1, value);
+	}
+	check(saturating.frequency(1) == 255, "Compact LFU: counter saturates at 255");
+	for (int key = 2; key <= 8; ++key) {
+		saturating.put(key, key);
+	}
+	check(saturating.frequency(1) == 255, "Compact LFU: saturated key is not evicted");
+}
+
+//̭:ѡĿ̭ǰȫʹʱ,̭Ȼܽ
+template <typename Cache>
+void checkSampledPoolEviction(const std::string& name) {
+	const int CAPACITY = 64;
+	Cache cache(CAPACITY, 5, 16);
+	int value = 0;
+	int next = 0;
+	for (; next < CAPACITY; ++next) {
+		cache.put(next, next);
+	}
+	for (int round = 0; round < 2000; ++round) {
+		//ȫִļ,кѡķѹʱ
+		for (int key = next - 2 * CAPACITY; key < next; ++key) {
+			cache.get(key, value);
+		}
+		cache.put(next, next);
+		++next;
+	}
+	check(cache.size() == static_cast<size_t>(CAPACITY), name + ": pool eviction terminates when every candidate was touched");
+}
+
+//LFU:ƵĶͦݵһɨ
+void checkSampledLfuHotKey() {
+	const int CAPACITY = 100;
+	CopCache::CopSampledLfuCache<int, int> cache(CAPACITY);
+	int value = 0;
+	for (int key = 0; key < CAPACITY; ++key) {
+		cache.put(key, key);
+	}
+	for (int n = 0; n < 1000; ++n) {
+		cache.get(0, value);
+	}
+	for (int key = CAPACITY; key < 3 * CAPACITY; ++key) {
+		cache.put(key, key);
+	}
+	check(cache.contains(0), "Sampled LFU: hot key survives a short one-pass scan");
+	//ٷʺ˥Ŀ,ձ̭
+	for (int key = 3 * CAPACITY; key < 40 * CAPACITY; ++key) {
+		cache.put(key, key);
+	}
+	check(!cache.contains(0), "Sampled LFU: a cold former hot key ages out");
+}
+
+//ڴдֵ,ļﱻ̭ľɸٱ
+template <typename Cache>
+void checkVictimTierOverwrite(const std::string& name) {
+	using Tier = CopCache::CopFileTier<int, int>;
+	int value = 0;
+	{
+		Cache cache(1);
+		cache.setVictimTier(std::make_shared<Tier>("/tmp/cop_regression_tier_a.log"));
+		cache.put(1, 10);
+		cache.put(2, 20);//1̭ļ
+		cache.put(1, 11, 5);
+		cache.invalidateTag(5);
+		check(!cache.get(1, value), name + ": invalidated tagged write does not resurrect tier copy");
+	}
+	{
+		Cache cache(1);
+		cache.setVictimTier(std::make_shared<Tier>("/tmp/cop_regression_tier_b.log"));
+		cache.put(1, 10);
+		cache.put(2, 20);
+		cache.put(1, 11, 7);
+		cache.put(3, 30);//ǩ1̭ʱļ
+		check(!cache.get(1, value) || value == 11, name + ": evicted tagged write does not expose older tier copy");
+	}
+}
+
+//GDSF:ͨӿ(ͨðװߵ·)ĿʱԭĴС,ͳƲܱС
+void checkGdsfGenericOverwrite() {
+	CopCache::CopGdsfCache<int, int> cache(100);
+	cache.put(1, 1, 5.0, 40);
+	cache.put(2, 2, 1.0, 10);
+	CopCache::CopCachePolicy<int, int>& base = cache;
+	base.put(1, 11);
+	int value = 0;
+	check(cache.usedSize() == 50 && cache.get(1, value) && value == 11, "GDSF: generic put keeps the stored size on overwrite");
+	base.put(3, 3);
+	check(cache.usedSize() == 51, "GDSF: generic put counts a new key as one unit");
+}
+
+//ļ:ѹֻˮλ(75%),֮ҪдһβŻٴѹ,µļ¼
+void checkFileTierCompaction() {
+	const int RECORD_BYTES = 16;//intֵ:ֶμӼֵ
+	const int CAPACITY_RECORDS = 1000;
+	const int LOW_WATER_RECORDS = CAPACITY_RECORDS * 3 / 4;
+	CopCache::CopFileTier<int, int> tier("/tmp/cop_regression_tier_c.log", CAPACITY_RECORDS * RECORD_BYTES, 1024, 512);
+	int key = 0;
+	for (; key <= CAPACITY_RECORDS; ++key) {
+		tier.store(key, key);
+	}
+	for (int wait = 0; wait < 200 && tier.size() > static_cast<size_t>(LOW_WATER_RECORDS); ++wait) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	check(tier.size() == static_cast<size_t>(LOW_WATER_RECORDS), "File tier: compaction keeps data down to the low-water mark");
+	//д벻ٴѹ
+	for (int n = 0; n < CAPACITY_RECORDS - LOW_WATER_RECORDS; ++n, ++key) {
+		tier.store(key, key);
+	}
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	int value = 0;
+	check(tier.size() == static_cast<size_t>(CAPACITY_RECORDS), "File tier: no new compaction until usage passes capacity again");
+	check(tier.take(key - 1, value) && value == key - 1, "File tier: newest record survives compaction");
+}
+
+#ifndef _WIN32
+//ڴ滺ıָ:ڳʼǰɱڳڼ䱻ɱ,֮Ľ̶ܿס
+void checkShmCrashRecovery() {
+	using Cache = CopCache::CopShmLruCache<int, long>;
+	const std::string name = "/cop_regression_shm";
+	Cache::unlink(name);
+	pid_t pid = fork();
+	if (pid == 0) {
+		//ģⴴõ֮󡢳ʼ֮ǰ
+		int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+		if (fd >= 0 && ftruncate(fd, 64) == 0) {
+			raise(SIGKILL);
+		}
+		_exit(1);
+	}
+	waitpid(pid, nullptr, 0);
+	{
+		Timer timer;
+		Cache cache(name, 1000, 4);
+		long value = 0;
+		cache.put(1, 10);
+		check(cache.isOpen() && cache.get(1, value) && value == 10, "SHM: joiner takes over a segment whose creator died");
+		std::cout << "  takeover after " << timer.elapsed() << " ms" << std::endl;
+
+		//̲ͣдʱSIGKILL,һĳƬ
+		for (int round = 0; round < 20; ++round) {
+			pid = fork();
+			if (pid == 0) {
+				Cache worker(name, 1000, 4);
+				for (int i = 0;; ++i) {
+					worker.put(i % 3000, i);
+				}
+			}
+			usleep(2000);
+			kill(pid, SIGKILL);
+			waitpid(pid, nullptr, 0);
+		}
+		bool usable = true;
+		for (int key = 0; key < 100; ++key) {
+			cache.put(key, key * 10L);
+			usable = usable && cache.get(key, value) && value == key * 10L;
+		}
+		check(usable, "SHM: cache stays usable after workers are killed mid-write");
+		std::cout << "  recovered shards: " << cache.recoveredShards() << std::endl;
+	}
+	Cache::unlink(name);
+}
+#endif
+
+void testRegressions() {
+	std::cout << "\n=== Test scenario 7: Regression checks ===" << std::endl;
+	checkVictimTierOverwrite<CopCache::CopLruCache<int, int>>("LRU");
+	checkVictimTierOverwrite<CopCache::CopLfuCache<int, int>>("LFU");
+	checkFileTierCompaction();
+	checkGdsfGenericOverwrite();
+	checkCompactLfuCounters();
+	checkSampledPoolEviction<CopCache::CopSampledLruCache<int, int>>("Sampled LRU");
+	checkSampledPoolEviction<CopCache::CopSampledLfuCache<int, int>>("Sampled LFU");
+	checkSampledLfuHotKey();
+#ifndef _WIN32
+	checkShmCrashRecovery();
+#endif
+}
+
 int main() {
 	testHotDataAccess();//ȵݲ
 	testLoopPattern();//ѭɨ
 	testWorkloadShift();//ؾұ仯
+	testStaticDispatch();//麯뾲̬ɶԱ
+	testScanResistance();//ȵ㼯ϻһɨ
+	testZipfLateScan();//ZipfֲӺɨ
+	testRegressions();//ع
 	std::cout << "Oh, it's finally done!>w<"<<std::endl;
-	return 0;
+	return regressionFailures == 0 ? 0 : 1;
 }
\ No newline at end of file